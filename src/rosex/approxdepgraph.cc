@@ -0,0 +1,190 @@
+// approxdepgraph.cc
+// 10/18/2026 jichi
+
+#include "rosex/approxdepgraph.h"
+#include "rosex/rosex.h"
+#include <boost/foreach.hpp>
+#include <boost/typeof/typeof.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#define foreach BOOST_FOREACH
+
+//#define DEBUG "approxdepgraph"
+#include "xt/xdebug.h"
+
+namespace { // anonymous
+
+  struct Reference
+  {
+    const SgNode *expression,
+                 *statement;
+    bool definition;
+  };
+  typedef std::vector<Reference> ReferenceList;
+
+  // Expression standing for the variable of ref, through array subscripts,
+  // pointer dereferences and field accesses on it
+  SgExpression *wholeReference(SgExpression *ref)
+  {
+    for (SgExpression *e = ref; ; ) {
+      SgNode *p = e->get_parent();
+      switch (p ? p->variantT() : V_SgNode) {
+      case V_SgPntrArrRefExp:
+      case V_SgDotExp:
+      case V_SgArrowExp:
+        if (::isSgBinaryOp(p)->get_lhs_operand() != e)
+          return e;
+        break;
+      case V_SgPointerDerefExp:
+        break;
+      default:
+        return e;
+      }
+      e = ::isSgExpression(p);
+    }
+  }
+
+  // Return if ref could modify its variable
+  bool isDefinition(SgExpression *ref)
+  {
+    SgNode *p = ref->get_parent();
+    if (!p)
+      return false;
+    if (SgBinaryOp *op = ::isSgBinaryOp(p))
+      return op->get_lhs_operand() == ref &&
+             (::isSgAssignOp(op) || ::isSgCompoundAssignOp(op));
+    switch (p->variantT()) {
+    case V_SgPlusPlusOp:
+    case V_SgMinusMinusOp:
+    case V_SgAddressOfOp:
+      return true;
+    case V_SgExprListExp:
+      // Arguments passed by reference, or arrays passed by pointer
+      if (::isSgFunctionCallExp(p->get_parent()))
+        return SageInterface::is_Fortran_language() || rosex::isArrayType(ref->get_type()) ||
+               ::isSgReferenceType(ref->get_type());
+      break;
+    default: ;
+    }
+    return SageInterface::getEnclosingNode<SgIOStatement>(ref);
+  }
+
+  // Variables in the COMMON blocks of root
+  boost::unordered_set<const SgNode *> commonVariables(SgNode *root)
+  {
+    boost::unordered_set<const SgNode *> ret;
+    foreach (SgNode *node, NodeQuery::querySubTree(root, V_SgCommonBlockObject))
+      if (SgExprListExp *l = ::isSgCommonBlockObject(node)->get_variable_reference_list())
+        foreach (SgExpression *e, l->get_expressions())
+          if (SgVarRefExp *ref = ::isSgVarRefExp(e))
+            if (SgVariableSymbol *s = ref->get_symbol())
+              ret.insert(s->get_declaration());
+    return ret;
+  }
+
+  // Return if var outlives the calls in root, so that they could read or write it,
+  // such as global, static, COMMON, and module variables, or parameters passed by reference
+  bool isNonLocal(SgInitializedName *var, const SgNode *root)
+  {
+    if (::isSgFunctionParameterList(var->get_parent())) {
+      SgType *t = var->get_type();
+      return SageInterface::is_Fortran_language() || rosex::isArrayType(t) ||
+             ::isSgPointerType(t) || ::isSgReferenceType(t);
+    }
+    if (!rosex::isAncestor(var, root))
+      return true;
+    SgDeclarationStatement *decl = var->get_declaration();
+    return decl && decl->get_declarationModifier().get_storageModifier().isStatic();
+  }
+
+} // anonymous namespace
+
+void ApproxDepGraph::build(SgNode *root)
+{
+  root_ = root;
+  edges_.clear();
+  stats_ = Statistics();
+  if (!root)
+    return;
+
+  // Group the references by variable in preorder, with null for the calls.
+  // References to non-local variables are also in the group of the calls.
+  boost::unordered_map<const SgNode *, ReferenceList> groups;
+  ReferenceList global; // calls and non-local references
+  bool calls = false;
+  boost::unordered_set<const SgNode *> common = commonVariables(root);
+  foreach (SgNode *node, NodeQuery::querySubTree(root, V_SgExpression)) {
+    SgInitializedName *var = nullptr;
+    SgExpression *ref = ::isSgExpression(node);
+    switch (node->variantT()) {
+    case V_SgVarRefExp:
+      {
+        SgNode *p = node->get_parent();
+        if ((::isSgDotExp(p) || ::isSgArrowExp(p)) && ::isSgBinaryOp(p)->get_rhs_operand() == ref)
+          continue; // field name
+        SgVariableSymbol *s = ::isSgVarRefExp(node)->get_symbol();
+        var = s ? s->get_declaration() : nullptr;
+        if (!var)
+          continue;
+        ref = wholeReference(ref);
+      } break;
+    case V_SgFunctionCallExp:
+      calls = true;
+      break;
+    default:
+      continue;
+    }
+    Reference r;
+    r.expression = ref;
+    r.statement = SageInterface::getEnclosingStatement(ref);
+    r.definition = !var || isDefinition(ref);
+    if (var)
+      groups[var].push_back(r);
+    if (!var || common.count(var) || isNonLocal(var, root))
+      global.push_back(r);
+  }
+  if (calls)
+    groups[nullptr].swap(global);
+
+  // Initialized declarations define their variables
+  foreach (SgNode *node, NodeQuery::querySubTree(root, V_SgInitializedName)) {
+    SgInitializedName *var = ::isSgInitializedName(node);
+    if (var->get_initializer()) {
+      BOOST_AUTO(p, groups.find(var));
+      if (p != groups.end()) {
+        Reference r;
+        r.expression = var;
+        r.statement = SageInterface::getEnclosingStatement(var);
+        r.definition = true;
+        p->second.push_back(r);
+      }
+    }
+  }
+
+  typedef boost::unordered_map<const SgNode *, ReferenceList>::value_type group_type;
+  foreach (const group_type &g, groups) {
+    const ReferenceList &l = g.second;
+    stats_.references += l.size();
+    size_t definitions = 0;
+    foreach (const Reference &r, l)
+      if (r.definition)
+        definitions++;
+    stats_.definitions += definitions;
+    if (!definitions)
+      continue;
+    stats_.groups++;
+    if (l.size() < 2)
+      continue;
+    // Each reference depends on the previous one, and the first on the last
+    for (size_t i = 0; i < l.size(); i++) {
+      const Reference &source = l[i ? i - 1 : l.size() - 1],
+                      &target = l[i];
+      Edge e = { source.expression, source.statement, target.expression, target.statement };
+      edges_.push_back(e);
+    }
+  }
+  XD("references = " << stats_.references << ", groups = " << stats_.groups << ", edges = " << edges_.size());
+}
+
+// EOF
@@ -0,0 +1,74 @@
+#ifndef _ROSEX_APPROXDEPGRAPH_H
+#define _ROSEX_APPROXDEPGRAPH_H
+
+// approxdepgraph.h
+// 10/18/2026 jichi
+// Approximate dependences of named variables in linear time.
+
+#include "xt/c++11.h"
+#include <vector>
+
+class SgNode;
+
+/**
+ *  \brief  Conservative replacement of DepGraph for large functions.
+ *
+ *  References are grouped by the variables they name, where an array element,
+ *  a pointer dereference, or a field access stands for the whole variable of
+ *  its base, and the subscripts are not analyzed. Function calls are grouped
+ *  together as references to the global state, and so are the references to
+ *  the variables that calls could access, such as global, static, COMMON, and
+ *  module variables, or parameters passed by reference, which then belong to
+ *  their own groups as well. A group with at least one
+ *  definition could have dependences between any two of its references, so
+ *  its references are linked into a cycle of edges, whose closure in DepSlice
+ *  is the same as the complete graph of the group with a linear number of
+ *  edges. Groups without definitions, such as read-only parameters, have no
+ *  edges.
+ *
+ *  Compared to DepGraph, there are no control dependences and every
+ *  dependence is assumed to be loop-carried, so that the slice keeps more
+ *  references. Building the graph takes one traversal of the AST and is
+ *  linear in the number of references.
+ */
+class ApproxDepGraph
+{
+  typedef ApproxDepGraph Self;
+
+public:
+  ///  Dependence from the source to the target reference.
+  struct Edge {
+    const SgNode *sourceExpression,
+                 *sourceStatement,
+                 *targetExpression,
+                 *targetStatement;
+  };
+
+  struct Statistics {
+    size_t references,  ///< references grouped, once in each of their groups
+           groups,      ///< variables and the global state with definitions
+           definitions; ///< references that could modify their variables, as references
+
+    Statistics() : references(0), groups(0), definitions(0) {}
+  };
+
+  explicit ApproxDepGraph(SgNode *root = nullptr) { build(root); }
+
+  ///  Build the dependences of the references in \p root, such as a function definition.
+  void build(SgNode *root);
+
+  bool valid() const { return root_; }
+  SgNode *root() const { return root_; }
+
+  const std::vector<Edge> &edges() const { return edges_; }
+  size_t num_edges() const { return edges_.size(); }
+
+  const Statistics &statistics() const { return stats_; }
+
+private:
+  SgNode *root_;
+  std::vector<Edge> edges_;
+  Statistics stats_;
+};
+
+#endif // _ROSEX_APPROXDEPGRAPH_H
@@ -0,0 +1,108 @@
+// budget.cc
+// 10/18/2026 jichi
+
+#include "rosex/budget.h"
+#include <cstdio>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace { // anonymous
+
+  double wallTime()
+  {
+    timeval tv;
+    ::gettimeofday(&tv, nullptr);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+  }
+
+} // anonymous namespace
+
+AnalysisBudget::AnalysisBudget(double seconds, size_t megabytes)
+  : seconds_(seconds), megabytes_(megabytes), startTime_(0), startMemory_(0),
+    resource_(None), checks_(0)
+{ start(); }
+
+void AnalysisBudget::start()
+{
+  startTime_ = wallTime();
+  startMemory_ = megabytes_ ? residentMemory() : 0;
+  resource_ = None;
+  checks_ = 0;
+}
+
+double AnalysisBudget::elapsed() const
+{ return wallTime() - startTime_; }
+
+AnalysisBudget::Resource AnalysisBudget::resource() const
+{ return Resource(resource_); }
+
+bool AnalysisBudget::exceeded() const
+{
+  if (!limited())
+    return false;
+  if (resource_ != None)
+    return true;
+  if (__sync_fetch_and_add(&checks_, 1) % CheckInterval)
+    return false;
+  update();
+  return resource_ != None;
+}
+
+bool AnalysisBudget::exceededNow() const
+{
+  if (!limited())
+    return false;
+  if (resource_ == None)
+    update();
+  return resource_ != None;
+}
+
+void AnalysisBudget::update() const
+{
+  // Only the first resource exceeded is kept
+  if (seconds_ > 0 && elapsed() > seconds_)
+    __sync_bool_compare_and_swap(&resource_, int(None), int(Time));
+  else if (megabytes_) {
+    size_t m = residentMemory();
+    if (m > startMemory_ && (m - startMemory_) >> 20 >= megabytes_)
+      __sync_bool_compare_and_swap(&resource_, int(None), int(Memory));
+  }
+}
+
+// See: proc(5) for /proc/self/statm, whose second field is the resident pages
+size_t AnalysisBudget::residentMemory()
+{
+  size_t ret = 0;
+  if (FILE *f = std::fopen("/proc/self/statm", "r")) {
+    unsigned long size, resident;
+    if (std::fscanf(f, "%lu %lu", &size, &resident) == 2)
+      ret = resident * ::sysconf(_SC_PAGESIZE);
+    std::fclose(f);
+  }
+  return ret ? ret : peakMemory(); // peak instead of current
+}
+
+// ru_maxrss is in KB on Linux and bytes on Mac
+size_t AnalysisBudget::peakMemory()
+{
+  rusage r;
+  if (::getrusage(RUSAGE_SELF, &r))
+    return 0;
+#ifdef __APPLE__
+  return r.ru_maxrss;
+#else
+  return r.ru_maxrss * 1024;
+#endif // __APPLE__
+}
+
+const char *AnalysisBudget::resourceName(Resource r)
+{
+  switch (r) {
+  case Time: return "time";
+  case Memory: return "memory";
+  default: return "none";
+  }
+}
+
+// EOF
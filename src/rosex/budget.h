@@ -0,0 +1,93 @@
+#ifndef _ROSEX_BUDGET_H
+#define _ROSEX_BUDGET_H
+
+// budget.h
+// 10/18/2026 jichi
+// Time and memory limits of the analysis of a function.
+
+#include "xt/c++11.h"
+#include <stdexcept>
+
+/**
+ *  \brief  Wall time and memory budget polled by long-running analyses.
+ *
+ *  The budget is started before analyzing a function, and the analyses check
+ *  it at their hot spots, such as each dependence test and edge of DepGraph.
+ *  Once exceeded, it stays exceeded until restarted, so that concurrent
+ *  analyses of the same function all stop. The analyses could not be killed
+ *  from outside, so an overrun is only noticed at the next check.
+ *
+ *  Memory is the growth of the resident set of the process since start(),
+ *  and would include the other threads if functions were analyzed
+ *  concurrently, so that a memory limit is only meaningful when a single
+ *  function is analyzed at a time; skgen ignores it with -sk:jobs.
+ *
+ *  Checks are lock-free, as they are made by every thread building the
+ *  regions of a graph. The clock and the memory are only read every
+ *  CheckInterval checks, as reading them is a system call, so that an overrun
+ *  could be noticed up to CheckInterval checks late. start() must not be
+ *  called while other threads are checking the budget.
+ */
+class AnalysisBudget
+{
+  typedef AnalysisBudget Self;
+
+public:
+  enum Resource { None = 0, Time, Memory };
+
+  enum { CheckInterval = 64 }; // checks between reading the clock and the memory usage
+
+  ///  Thrown by check() to abort the analysis.
+  class Exceeded : public std::runtime_error
+  {
+  public:
+    Exceeded() : std::runtime_error("warning: analysis budget exceeded, abort analysis.") {}
+  };
+
+  ///  \p seconds and \p megabytes  Limits, or 0 for unlimited
+  explicit AnalysisBudget(double seconds = 0, size_t megabytes = 0);
+
+  double seconds() const { return seconds_; }
+  size_t megabytes() const { return megabytes_; }
+  bool limited() const { return seconds_ > 0 || megabytes_; }
+
+  ///  Restart the clock and the memory baseline.
+  void start();
+
+  ///  Return if any limit is exceeded, read every CheckInterval checks.
+  bool exceeded() const;
+
+  ///  Return if any limit is exceeded, read now, such as between two analyses.
+  bool exceededNow() const;
+
+  ///  Throw Exceeded if exceeded().
+  void check() const { if (exceeded()) throw Exceeded(); }
+
+  ///  The first resource exceeded, or None.
+  Resource resource() const;
+
+  ///  Wall time in seconds since start().
+  double elapsed() const;
+
+  ///  Resident set size of the process in bytes, or 0 if not supported.
+  static size_t residentMemory();
+
+  ///  Peak resident set size of the process in bytes, or 0 if not supported.
+  static size_t peakMemory();
+
+  static const char *resourceName(Resource r);
+
+private:
+  double seconds_;
+  size_t megabytes_;
+  double startTime_;
+  size_t startMemory_;
+
+  void update() const; // read the clock and the memory
+
+  // Updated atomically by the checks
+  mutable volatile int resource_; // Resource
+  mutable volatile unsigned long checks_;
+};
+
+#endif // _ROSEX_BUDGET_H
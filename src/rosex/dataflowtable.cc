@@ -342,11 +342,13 @@ public:
 bool DataFlowTable::Reference::isTemporary() const
 { return boost::starts_with(symbol, DFT_TEMP_PREFIX); }
 
+static int tempCount_ = 0; // number of temporary references created
+
+int DataFlowTable::Reference::tempCount() { return tempCount_; }
+void DataFlowTable::Reference::setTempCount(int val) { tempCount_ = val; }
+
 DataFlowTable::Reference DataFlowTable::Reference::createTemp(SgNode *src)
-{
-  static int id = 0;
-  return Reference(DFT_TEMP_PREFIX + boost::lexical_cast<std::string>(++id), src);
-}
+{ return Reference(DFT_TEMP_PREFIX + boost::lexical_cast<std::string>(++tempCount_), src); }
 
 DataFlowTable::Reference DataFlowTable::Reference::createSymbol(SgNode *src)
 { return Reference(SymbolicValue::fromSource(src), src); }
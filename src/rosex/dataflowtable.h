@@ -51,6 +51,10 @@ protected:
     ///  Create temporary reference
     static Reference createTemp(SgNode *src = nullptr);
 
+    ///  Number of temporary references created, used to number the next one.
+    static int tempCount();
+    static void setTempCount(int val);
+
     ///  Return if this reference is a temporary variable
     bool isTemporary() const;
 
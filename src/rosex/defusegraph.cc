@@ -2,6 +2,7 @@
 // Since 7/5/2011
 
 #include "rosex/rosex.h"
+#include "rosex/slice_p.h"
 
 #include "defusegraph.h"
 #include <AstInterface_ROSE.h>
@@ -153,6 +154,9 @@ namespace { // anonymous, graph builders
 
     ROSE_ASSERT(enclosing_function);
 
+    // ROSE side effect and alias analysis share process-wide statics
+    boost::unique_lock<boost::shared_mutex> lock(slice::globalAnalysisMutex());
+
     AstInterfaceImpl fa_impl(enclosing_function);
     AstInterface fa(&fa_impl);
 
@@ -0,0 +1,604 @@
+// depexact_p.cc
+// 10/18/2026 jichi
+// See: W. Pugh, The Omega test: a fast and practical integer programming
+// algorithm for dependence analysis, 1991.
+
+#include "rosex/rosex.h"
+#include "rosex/slice_p.h"
+#include "rosex/depexact_p.h"
+#include <boost/foreach.hpp>
+#include <boost/math/common_factor_rt.hpp>
+#include <boost/typeof/typeof.hpp>
+#include <boost/unordered_map.hpp>
+#include <climits>
+#include <map>
+#include <vector>
+
+#define foreach BOOST_FOREACH
+
+//#define DEBUG "depexact_p"
+#include "xt/xdebug.h"
+
+enum { MaxConstraints = 256 };     // give up on larger systems
+enum { MaxCoefficient = 1 << 30 }; // give up on larger values to avoid overflow
+
+namespace { // anonymous, constraints
+
+  typedef long long integer;
+  typedef std::vector<integer> Coefficients;
+
+  inline bool inRange(integer v) { return v >= -MaxCoefficient && v <= MaxCoefficient; }
+
+  // Floor of a / b for b > 0
+  inline integer floorDiv(integer a, integer b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+
+  // Conjunction of sum(a[k] * v[k]) + c >= 0 over integer variables v
+  class ConstraintSystem
+  {
+    typedef std::map<Coefficients, integer> RowMap; // tightest constant of each row
+
+    size_t vars_;
+    RowMap rows_;
+    bool feasible_,
+         exact_,
+         overflow_;
+
+  public:
+    explicit ConstraintSystem(size_t vars)
+      : vars_(vars), feasible_(true), exact_(true), overflow_(false) {}
+
+    size_t vars() const { return vars_; }
+
+    ///  False if the real shadow is proven empty.
+    bool feasible() const { return feasible_; }
+    ///  If every elimination so far keeps the integer points.
+    bool exact() const { return exact_; }
+    ///  If the values or the number of constraints exceeded the limits.
+    bool overflow() const { return overflow_; }
+
+    void setInexact() { exact_ = false; }
+
+    void addVariable()
+    {
+      RowMap rows;
+      foreach (const RowMap::value_type &r, rows_) {
+        Coefficients a = r.first;
+        a.push_back(0);
+        rows[a] = r.second;
+      }
+      rows_.swap(rows);
+      vars_++;
+    }
+
+    void add(Coefficients a, integer c);
+
+    void addEquality(const Coefficients &a, integer c)
+    {
+      add(a, c);
+      Coefficients b(a);
+      foreach (integer &x, b)
+        x = -x;
+      add(b, -c);
+    }
+
+    ///  Eliminate the variables other than \p keep, or all if \p keep is out of range.
+    void project(size_t keep);
+
+    ///  Integer bounds of variable \p k after project(k).
+    void bounds(size_t k, bool &hasLower, integer &lower, bool &hasUpper, integer &upper) const;
+
+  private:
+    void eliminate(size_t k);
+  };
+
+  void ConstraintSystem::add(Coefficients a, integer c)
+  {
+    integer g = 0;
+    foreach (integer x, a)
+      g = boost::math::gcd(g, x < 0 ? -x : x);
+    if (!g) {
+      if (c < 0)
+        feasible_ = false;
+      return;
+    }
+    if (g > 1) {
+      foreach (integer &x, a)
+        x /= g;
+      c = floorDiv(c, g); // integer tightening
+    }
+    bool ok = inRange(c);
+    foreach (integer x, a)
+      ok = ok && inRange(x);
+    if (!ok) {
+      overflow_ = true;
+      return;
+    }
+    std::pair<RowMap::iterator, bool> p = rows_.insert(std::make_pair(a, c));
+    if (!p.second && c < p.first->second)
+      p.first->second = c;
+    if (rows_.size() > MaxConstraints)
+      overflow_ = true;
+  }
+
+  // Combine each lower bound p*v + L >= 0 with each upper bound -n*v + U >= 0 into n*L + p*U >= 0.
+  // The combination keeps the integer points if p or n is 1.
+  void ConstraintSystem::eliminate(size_t k)
+  {
+    std::vector<RowMap::value_type> lower, upper;
+    RowMap rest;
+    foreach (const RowMap::value_type &r, rows_)
+      if (r.first[k] > 0)
+        lower.push_back(r);
+      else if (r.first[k] < 0)
+        upper.push_back(r);
+      else
+        rest.insert(r);
+    rows_.swap(rest);
+
+    foreach (const RowMap::value_type &l, lower)
+      foreach (const RowMap::value_type &u, upper) {
+        integer p = l.first[k],
+                n = -u.first[k];
+        if (p != 1 && n != 1)
+          exact_ = false;
+        Coefficients a(vars_);
+        for (size_t i = 0; i < vars_; i++)
+          a[i] = n * l.first[i] + p * u.first[i];
+        add(a, n * l.second + p * u.second);
+        if (overflow_ || !feasible_)
+          return;
+      }
+  }
+
+  void ConstraintSystem::project(size_t keep)
+  {
+    std::vector<bool> done(vars_);
+    if (keep < vars_)
+      done[keep] = true;
+    while (feasible_ && !overflow_) {
+      // Prefer exact eliminations, and then fewer combinations
+      size_t best = vars_,
+             bestCost = 0;
+      bool bestExact = false;
+      for (size_t k = 0; k < vars_; k++)
+        if (!done[k]) {
+          size_t lower = 0,
+                 upper = 0;
+          bool unitLower = true,
+               unitUpper = true;
+          foreach (const RowMap::value_type &r, rows_)
+            if (r.first[k] > 0) {
+              lower++;
+              unitLower = unitLower && r.first[k] == 1;
+            } else if (r.first[k] < 0) {
+              upper++;
+              unitUpper = unitUpper && r.first[k] == -1;
+            }
+          bool exact = unitLower || unitUpper;
+          size_t cost = lower * upper;
+          if (best == vars_ || (exact && !bestExact) || (exact == bestExact && cost < bestCost)) {
+            best = k;
+            bestCost = cost;
+            bestExact = exact;
+          }
+        }
+      if (best == vars_)
+        break;
+      done[best] = true;
+      eliminate(best);
+    }
+  }
+
+  void ConstraintSystem::bounds(size_t k, bool &hasLower, integer &lower, bool &hasUpper, integer &upper) const
+  {
+    hasLower = hasUpper = false;
+    foreach (const RowMap::value_type &r, rows_) {
+      // Rows are normalized, so that the only coefficient is 1 or -1
+      integer a = r.first[k],
+              c = r.second;
+      if (a == 1 && (!hasLower || -c > lower)) {
+        hasLower = true;
+        lower = -c;
+      } else if (a == -1 && (!hasUpper || c < upper)) {
+        hasUpper = true;
+        upper = c;
+      }
+    }
+  }
+
+} // anonymous namespace
+
+namespace { // anonymous, references
+
+  // Affine expression over the columns of a constraint system
+  struct Linear
+  {
+    std::map<size_t, integer> terms; // column to coefficient
+    integer constant;
+
+    Linear() : constant(0) {}
+
+    bool isConstant() const { return terms.empty(); }
+
+    bool scale(integer k)
+    {
+      if (!inRange(k))
+        return false;
+      if (!k) {
+        terms.clear();
+        constant = 0;
+        return true;
+      }
+      constant *= k;
+      bool ret = inRange(constant);
+      for (std::map<size_t, integer>::iterator p = terms.begin(); p != terms.end(); ++p)
+        ret = inRange(p->second *= k) && ret;
+      return ret;
+    }
+
+    bool add(const Linear &that, integer sign)
+    {
+      constant += sign * that.constant;
+      bool ret = inRange(constant);
+      for (std::map<size_t, integer>::const_iterator p = that.terms.begin(); p != that.terms.end(); ++p) {
+        integer &c = terms[p->first];
+        c += sign * p->second;
+        ret = inRange(c) && ret;
+        if (!c)
+          terms.erase(p->first);
+      }
+      return ret;
+    }
+
+    Coefficients coefficients(size_t vars) const
+    {
+      Coefficients ret(vars);
+      for (std::map<size_t, integer>::const_iterator p = terms.begin(); p != terms.end(); ++p)
+        ret[p->first] = p->second;
+      return ret;
+    }
+  };
+
+  struct Loop
+  {
+    SgInitializedName *var;
+    SgExpression *lb,
+                 *ub,
+                 *step;
+    bool incremental,
+         inclusive;
+  };
+
+  // Enclosing loops of the statement of a reference, in columns from offset
+  struct Side
+  {
+    SgNode *stmt;
+    std::vector<Loop> loops;
+    size_t offset;
+  };
+
+  bool getLoops(SgNode *stmt, std::vector<Loop> &ret)
+  {
+    std::vector<SgNode *> l;
+    if (!rosex::getEnclosingLoops(stmt, l))
+      return false;
+    foreach (SgNode *node, l) {
+      Loop loop = { nullptr, nullptr, nullptr, nullptr, false, false };
+      if (!rosex::isCanonicalLoop(node, &loop.var, &loop.lb, &loop.ub, &loop.step, nullptr,
+                                  &loop.incremental, &loop.inclusive))
+        return false;
+      ret.push_back(loop);
+    }
+    return true;
+  }
+
+  // Columns of the symbolic constants shared by both references
+  class Linearizer
+  {
+    DepExactTest &test_;
+    boost::unordered_map<const SgNode *, size_t> symbols_;
+    size_t nextColumn_;
+
+  public:
+    Linearizer(DepExactTest &test, size_t firstSymbolColumn)
+      : test_(test), nextColumn_(firstSymbolColumn) {}
+
+    size_t columns() const { return nextColumn_; }
+
+    ///  Linearize \p e in the first \p depth loops of \p side.
+    bool linearize(SgExpression *e, const Side &side, size_t depth, Linear &ret);
+
+  private:
+    bool variable(const SgNode *var, const Side &side, size_t depth, Linear &ret);
+  };
+
+  bool Linearizer::variable(const SgNode *var, const Side &side, size_t depth, Linear &ret)
+  {
+    if (!var)
+      return false;
+    // The innermost loop of the variable
+    for (size_t i = depth; i; i--)
+      if (side.loops[i - 1].var == var) {
+        ret.terms[side.offset + i - 1] = 1;
+        return true;
+      }
+    if (!test_.isInvariant(var, side.stmt))
+      return false;
+    BOOST_AUTO(p, symbols_.find(var));
+    size_t column = p != symbols_.end() ? p->second : (symbols_[var] = nextColumn_++);
+    ret.terms[column] = 1;
+    return true;
+  }
+
+  bool Linearizer::linearize(SgExpression *e, const Side &side, size_t depth, Linear &ret)
+  {
+    ret = Linear();
+    if (!e)
+      return false;
+    switch (e->variantT()) {
+    case V_SgVarRefExp:
+      {
+        SgVariableSymbol *s = ::isSgVarRefExp(e)->get_symbol();
+        return variable(s ? s->get_declaration() : nullptr, side, depth, ret);
+      }
+    case V_SgAssignInitializer:
+      return linearize(::isSgAssignInitializer(e)->get_operand(), side, depth, ret);
+    case V_SgCastExp:
+      return rosex::isIntegerType(e->get_type()) &&
+             linearize(::isSgCastExp(e)->get_operand(), side, depth, ret);
+    case V_SgUnaryAddOp:
+      return linearize(::isSgUnaryOp(e)->get_operand(), side, depth, ret);
+    case V_SgMinusOp:
+      return linearize(::isSgUnaryOp(e)->get_operand(), side, depth, ret) && ret.scale(-1);
+    case V_SgAddOp:
+    case V_SgSubtractOp:
+    case V_SgMultiplyOp:
+      {
+        SgBinaryOp *op = ::isSgBinaryOp(e);
+        Linear rhs;
+        if (!linearize(op->get_lhs_operand(), side, depth, ret) ||
+            !linearize(op->get_rhs_operand(), side, depth, rhs))
+          return false;
+        switch (e->variantT()) {
+        case V_SgAddOp: return ret.add(rhs, 1);
+        case V_SgSubtractOp: return ret.add(rhs, -1);
+        default:
+          if (rhs.isConstant())
+            return ret.scale(rhs.constant);
+          if (ret.isConstant()) {
+            integer k = ret.constant;
+            ret = rhs;
+            return ret.scale(k);
+          }
+          return false;
+        }
+      }
+    default:
+      if (::isSgValueExp(e) && rosex::isIntegerType(e->get_type())) {
+        bool ok;
+        ret.constant = rosex::evalLongLong(e, &ok);
+        return ok && inRange(ret.constant);
+      }
+      return false;
+    }
+  }
+
+  // Linear >= 0, or == 0
+  struct Constraint
+  {
+    Linear value;
+    bool equality;
+  };
+
+  // a - b + c
+  bool difference(const Linear &a, const Linear &b, integer c, Linear &ret)
+  {
+    ret = a;
+    ret.constant += c;
+    return ret.add(b, -1);
+  }
+
+  // Add the iteration space of the loops of side
+  void addLoopConstraints(Linearizer &lin, const Side &side, std::vector<Constraint> &ret, bool &exact)
+  {
+    for (size_t k = 0; k < side.loops.size(); k++) {
+      const Loop &loop = side.loops[k];
+      Linear x;
+      x.terms[side.offset + k] = 1;
+
+      // Strides are not modeled
+      if (loop.step) {
+        Linear step;
+        if (!lin.linearize(loop.step, side, k, step) || !step.isConstant() ||
+            (step.constant != 1 && step.constant != -1))
+          exact = false;
+      }
+
+      // Incremental: lb <= x <= ub, decremental: ub <= x <= lb, exclusive of ub if not inclusive
+      Linear lb, ub;
+      Constraint c;
+      c.equality = false;
+      if (lin.linearize(loop.lb, side, k, lb) &&
+          (loop.incremental ? difference(x, lb, 0, c.value) : difference(lb, x, 0, c.value)))
+        ret.push_back(c);
+      else
+        exact = false;
+      integer exclusive = loop.inclusive ? 0 : -1;
+      if (lin.linearize(loop.ub, side, k, ub) &&
+          (loop.incremental ? difference(ub, x, exclusive, c.value) : difference(x, ub, exclusive, c.value)))
+        ret.push_back(c);
+      else
+        exact = false;
+    }
+  }
+
+  // Relation of the distance between a source and a target loop variable
+  DepRel relation(bool hasLower, integer lower, bool hasUpper, integer upper)
+  {
+    hasLower = hasLower && lower > INT_MIN / 2;
+    hasUpper = hasUpper && upper < INT_MAX / 2;
+    if (hasLower && hasUpper)
+      return lower == upper ? DepRel(DEPDIR_EQ, int(lower)) :
+                              DepRel(DEPDIR_LE, int(lower), int(upper));
+    if (hasUpper)
+      return DepRel(DEPDIR_LE, int(upper));
+    if (hasLower)
+      return DepRel(DEPDIR_GE, int(lower));
+    return DepRel(DEPDIR_ALL);
+  }
+
+  // Return if ref could modify its scalar variable
+  bool isModification(SgExpression *ref, bool byReference)
+  {
+    SgNode *p = ref->get_parent();
+    if (!p)
+      return false;
+    if (SgBinaryOp *op = ::isSgBinaryOp(p))
+      return op->get_lhs_operand() == ref && (::isSgAssignOp(op) || ::isSgCompoundAssignOp(op));
+    switch (p->variantT()) {
+    case V_SgPlusPlusOp:
+    case V_SgMinusMinusOp:
+    case V_SgAddressOfOp:
+      return true;
+    case V_SgExprListExp:
+      if (byReference && ::isSgFunctionCallExp(p->get_parent()))
+        return true;
+      break;
+    default: ;
+    }
+    return SageInterface::getEnclosingNode<SgIOStatement>(ref);
+  }
+
+} // anonymous namespace
+
+// - Invariants -
+
+bool DepExactTest::isInvariant(const SgNode *var, SgNode *stmt)
+{
+  const SgInitializedName *v = ::isSgInitializedName(var);
+  SgType *t = v ? v->get_type() : nullptr;
+  if (!t || !rosex::isIntegerType(t->stripTypedefsAndModifiers()))
+    return false;
+  SgFunctionDefinition *f = SageInterface::getEnclosingFunctionDefinition(stmt);
+  if (!f)
+    return false;
+
+  if (f != function_) {
+    function_ = f;
+    modified_.clear();
+    hasCalls_ = false;
+    bool byReference = !SageInterface::is_C_language();
+    foreach (SgNode *node, NodeQuery::querySubTree(f, V_SgExpression))
+      if (::isSgFunctionCallExp(node))
+        hasCalls_ = true;
+      else if (SgVarRefExp *r = ::isSgVarRefExp(node))
+        if (isModification(r, byReference))
+          if (SgVariableSymbol *s = r->get_symbol())
+            modified_.insert(s->get_declaration());
+    // Variables declared in loops have a value per iteration
+    foreach (SgNode *node, NodeQuery::querySubTree(f, V_SgInitializedName)) {
+      std::vector<SgNode *> loops;
+      if (!rosex::getEnclosingLoops(node, loops) || !loops.empty())
+        modified_.insert(node);
+    }
+  }
+
+  if (modified_.count(var))
+    return false;
+  // Non-local variables could be modified by the callees
+  if (!hasCalls_)
+    return true;
+  const SgNode *p = v->get_parent();
+  return SageInterface::getEnclosingFunctionDefinition(const_cast<SgInitializedName *>(v)) == f ||
+         (::isSgFunctionParameterList(p) && p->get_parent() == f->get_declaration());
+}
+
+// - Test -
+
+DepExactTest::Result DepExactTest::test(const DepInfoAnal::StmtRefDep &ref, DepType deptype, DepInfo &ret)
+{
+  std::vector<SgExpression *> sub1, sub2;
+  const SgInitializedName *a1 = rosex::getArrayAccess(slice::astnode_cast<SgNode *>(ref.r1.ref), sub1),
+                          *a2 = rosex::getArrayAccess(slice::astnode_cast<SgNode *>(ref.r2.ref), sub2);
+  if (!a1 || a1 != a2 || sub1.empty() || sub1.size() != sub2.size() ||
+      !rosex::isDeclaredArray(a1, SageInterface::is_Fortran_language()))
+    return Unknown;
+
+  Side src, snk;
+  src.stmt = slice::astnode_cast<SgNode *>(ref.r1.stmt);
+  snk.stmt = slice::astnode_cast<SgNode *>(ref.r2.stmt);
+  if (!getLoops(src.stmt, src.loops) || !getLoops(snk.stmt, snk.loops))
+    return Unknown;
+  src.offset = 0;
+  snk.offset = src.loops.size();
+
+  // Columns: source loops, target loops, symbolic constants
+  bool exact = true;
+  Linearizer lin(*this, src.loops.size() + snk.loops.size());
+  std::vector<Constraint> constraints;
+  addLoopConstraints(lin, src, constraints, exact);
+  addLoopConstraints(lin, snk, constraints, exact);
+  for (size_t d = 0; d < sub1.size(); d++) {
+    Linear f, g;
+    if (lin.linearize(sub1[d], src, src.loops.size(), f) &&
+        lin.linearize(sub2[d], snk, snk.loops.size(), g) &&
+        f.add(g, -1)) {
+      Constraint c = { f, true };
+      constraints.push_back(c);
+    } else
+      exact = false;
+  }
+
+  ConstraintSystem system(lin.columns());
+  if (!exact)
+    system.setInexact();
+  foreach (const Constraint &c, constraints)
+    if (c.equality)
+      system.addEquality(c.value.coefficients(system.vars()), c.value.constant);
+    else
+      system.add(c.value.coefficients(system.vars()), c.value.constant);
+
+  // Emptiness of the real shadow is exact regardless of the eliminations
+  ConstraintSystem shadow = system;
+  shadow.project(size_t(-1));
+  if (shadow.overflow())
+    return Unknown;
+  if (!shadow.feasible())
+    return Independent;
+  if (!shadow.exact())
+    return Unknown;
+
+  // Distance between each pair of source and target loops
+  bool precise = true;
+  std::vector<DepRel> relations;
+  for (size_t i = 0; i < src.loops.size(); i++)
+    for (size_t j = 0; j < snk.loops.size(); j++) {
+      ConstraintSystem s = system;
+      s.addVariable();
+      size_t d = s.vars() - 1;
+      Coefficients a(s.vars());
+      a[d] = 1;
+      a[src.offset + i] = -1;
+      a[snk.offset + j] = 1;
+      s.addEquality(a, 0);
+      s.project(d);
+      bool hasLower = false,
+           hasUpper = false;
+      integer lower = 0,
+              upper = 0;
+      if (!s.overflow())
+        s.bounds(d, hasLower, lower, hasUpper, upper);
+      precise = precise && s.exact() && !s.overflow();
+      relations.push_back(relation(hasLower, lower, hasUpper, upper));
+    }
+
+  ret = DepInfoGenerator::GetDepInfo(src.loops.size(), snk.loops.size(), deptype,
+                                     ref.r1.ref, ref.r2.ref, precise, ref.commLevel);
+  for (size_t i = 0; i < src.loops.size(); i++)
+    for (size_t j = 0; j < snk.loops.size(); j++)
+      ret.Entry(i, j) = relations[i * snk.loops.size() + j];
+  XD("rows = " << src.loops.size() << ", cols = " << snk.loops.size() << ", precise = " << precise);
+  return Dependent;
+}
+
+// EOF
@@ -0,0 +1,59 @@
+#ifndef _ROSEX_DEPEXACT_P_H
+#define _ROSEX_DEPEXACT_P_H
+
+// depexact_p.h
+// 10/18/2026 jichi
+// Internal header for the exact dependence test of affine loop nests.
+
+#include "rosex/rose_config.h"
+#include "xt/c++11.h"
+#include <DepInfoAnal.h>
+#include <boost/unordered_set.hpp>
+
+class SgNode;
+
+/**
+ *  \internal
+ *  \brief  Integer set dependence test of affine references.
+ *
+ *  The two references must access the same declared array with subscripts
+ *  affine in the variables of their canonical enclosing loops and in integer
+ *  scalars never modified in the function. The iteration spaces and the
+ *  equal subscripts form a system of linear constraints over the source and
+ *  target loop variables and the scalars, which is decided by Fourier-Motzkin
+ *  elimination with integer tightening. As in the Omega test, an elimination
+ *  is exact if one side of each combined pair has a unit coefficient, so
+ *  that the real shadow has no integer point without an integer preimage.
+ *
+ *  - If the real shadow is empty, the references are independent.
+ *  - If all eliminations are exact, the range of the distance between each
+ *    pair of source and target loops is projected exactly, and returned as
+ *    the relations of a precise DepInfo.
+ *  - Otherwise, such as with strides or non-unit coefficients, the test does
+ *    not answer and ROSE is used instead.
+ *
+ *  The relation of source loop i and target loop j is over the difference of
+ *  their variables, i.e. DEPDIR_EQ for a constant distance, or DEPDIR_LE and
+ *  DEPDIR_GE when only one side is bounded.
+ */
+class DepExactTest
+{
+  typedef DepExactTest Self;
+
+  const SgNode *function_; // of the modified variables
+  boost::unordered_set<const SgNode *> modified_; // variables
+  bool hasCalls_;
+
+public:
+  enum Result { Unknown = 0, Independent, Dependent };
+
+  DepExactTest() : function_(nullptr), hasCalls_(false) {}
+
+  ///  Return Dependent with the relations in \p ret, or Independent, or Unknown if not exact.
+  Result test(const DepInfoAnal::StmtRefDep &ref, DepType deptype, DepInfo &ret);
+
+  ///  Return if \p var could be used as a symbolic constant in \p stmt.
+  bool isInvariant(const SgNode *var, SgNode *stmt);
+};
+
+#endif // _ROSEX_DEPEXACT_P_H
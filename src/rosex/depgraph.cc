@@ -5,6 +5,7 @@
 #include "rosex/slice_p.h"
 #include "rosex/depgraph.h"
 #include "rosex/depgraph_p.h"
+#include "rosex/depgraphfile.h"
 #include <GraphDotOutput.h>
 #include <DepInfo.h>
 //#include <sstream>
@@ -13,6 +14,7 @@
 #include <boost/smart_ptr.hpp>
 #include <boost/typeof/typeof.hpp>
 #include <algorithm>
+#include <map>
 
 #ifdef __clang__
 # pragma GCC diagnostic ignored "-Wparentheses"
@@ -48,43 +50,20 @@ namespace boost {
 namespace { static const DepInfo NO_DEP_INFO; } // used as null depinfo
 namespace { static const DepRel NO_DEP_REL; } // used as null deprel
 
-// -- Helper functions --
-
-namespace { // anonymous, algorithm
-
-  template <typename InputIterator>
-  inline size_t
-  count(InputIterator first, InputIterator last)
-  {
-    if (first == last)
-      return 0;
-
-    size_t ret = 1;
-    while (++first != last) ++ret;
-    return ret;
-  }
-
-  template <typename SinglePassRange>
-  inline BOOST_DEDUCED_TYPENAME boost::range_difference<SinglePassRange>::type
-  count(const SinglePassRange &r)
-  { return count(boost::begin(r), boost::end(r)); }
-
-} // namespace aonymous
-
 // - Construction -
 
 struct DepGraphPrivateData
 {
-  boost::scoped_ptr<
-      std::list<DepGraph::edge_type>
-  > p_edges;
-  boost::scoped_ptr<
-      boost::unordered_map<DepGraph::vertex_type, int>
-  > p_indices;
+  DepGraphSnapshot snapshot;
+  boost::unordered_map<DepGraph::vertex_type, int> indices; // vertex_index property
+  bool compacted;
+
+  DepGraphPrivateData() : compacted(false) {}
 };
 
 DepGraphPrivate::DepGraphPrivate(const DepGraphOption *option)
-  : data(new DepGraphPrivateData)
+  : graph(nullptr, option && option->arena)
+  , data(new DepGraphPrivateData)
   , option(option)
 {}
 
@@ -178,20 +157,210 @@ bool DepGraphEdgeIterator::equal(const Self &that) const
       || Base::operator==(that);
 }
 
+// - Snapshot -
+
+size_t DepGraphSnapshot::index(vertex_type v) const
+{
+  BOOST_AUTO(p, vertexIndices_.find(v));
+  return p == vertexIndices_.end() ? npos : p->second;
+}
+
+size_t DepGraphSnapshot::index(edge_type e) const
+{
+  BOOST_AUTO(p, edgeIndices_.find(e));
+  return p == edgeIndices_.end() ? npos : p->second;
+}
+
+namespace { // anonymous, snapshot
+
+  struct EdgeTargetLess
+  {
+    typedef std::pair<DepGraphSnapshot::EdgeRecord, DepGraphEdge> value_type;
+    bool operator()(const value_type &x, const value_type &y) const
+    { return x.first.target < y.first.target; }
+  };
+
+  ///  Order edge numbers by their types.
+  class EdgeTypeLess
+  {
+    const std::vector<DepGraphSnapshot::EdgeRecord> &records_;
+  public:
+    explicit EdgeTypeLess(const std::vector<DepGraphSnapshot::EdgeRecord> &records)
+      : records_(records) {}
+    bool operator()(size_t x, size_t y) const
+    { return records_[x].type < records_[y].type; }
+  };
+
+} // anonymous namespace
+
+void DepGraphSnapshot::build(DepGraphPrivate::Graph &g)
+{
+  typedef DepGraphPrivate D;
+  for (D::VertexIterator p = g.GetNodeIterator(); !p.ReachEnd(); ++p)
+    if (D::Vertex *n = p.Current()) {
+      vertexIndices_[n] = vertices_.size();
+      vertices_.push_back(n);
+      // The first vertex of a statement, consistent with the former linear search
+      statementIndices_.insert(std::make_pair(n->statement(), vertices_.size() - 1));
+    }
+
+  const size_t vertexCount = vertices_.size();
+  outOffsets_.reserve(vertexCount + 1);
+  std::vector<size_t> inDegrees(vertexCount);
+  std::vector<EdgeTargetLess::value_type> l; // out-edges of a vertex
+  for (size_t v = 0; v < vertexCount; v++) {
+    outOffsets_.push_back(outEdges_.size());
+
+    l.clear();
+    for (D::EdgeIterator p = g.GetNodeEdgeIterator(vertices_[v], GraphAccess::EdgeOut); !p.ReachEnd(); ++p)
+      if (D::Edge *e = p.Current()) {
+        EdgeRecord r;
+        r.source = v;
+        r.target = index(vertex_type(g.GetEdgeEndPoint(e, GraphAccess::EdgeIn)));
+        ROSE_ASSERT(r.target != npos);
+        r.type = e->GetInfo().GetDepType();
+        r.sourceExpression = slice::astnode_cast<SgNode *>(e->GetInfo().SrcRef());
+        r.targetExpression = slice::astnode_cast<SgNode *>(e->GetInfo().SnkRef());
+        l.push_back(EdgeTargetLess::value_type(r, e));
+      }
+
+    // Parallel edges become contiguous
+    std::stable_sort(l.begin(), l.end(), EdgeTargetLess());
+    for (size_t i = 0; i < l.size(); i++) {
+      size_t id = outEdges_.size();
+      const EdgeRecord &r = l[i].first;
+      if (!i || r.target != l[i - 1].first.target)
+        pairIndices_[std::make_pair(v, r.target)] = std::make_pair(id, id + 1);
+      else
+        pairIndices_[std::make_pair(v, r.target)].second++;
+
+      edgeIndices_[l[i].second] = id;
+      outEdges_.push_back(l[i].second);
+      records_.push_back(r);
+      inDegrees[r.target]++;
+    }
+  }
+  outOffsets_.push_back(outEdges_.size());
+
+  // Group the in-edges by counting sort, stable in the order of the edge numbers
+  inOffsets_.assign(vertexCount + 1, 0);
+  for (size_t i = 0; i < vertexCount; i++)
+    inOffsets_[i + 1] = inOffsets_[i] + inDegrees[i];
+  std::vector<size_t> pos(inOffsets_.begin(), inOffsets_.end() - 1);
+  inEdges_.resize(outEdges_.size());
+  inEdgeIndices_.resize(outEdges_.size());
+  for (size_t i = 0; i < records_.size(); i++) {
+    size_t j = pos[records_[i].target]++;
+    inEdges_[j] = outEdges_[i];
+    inEdgeIndices_[j] = i;
+  }
+
+  // Partition by types
+  std::vector<size_t> outEdgeIndices(outEdges_.size());
+  for (size_t i = 0; i < outEdgeIndices.size(); i++)
+    outEdgeIndices[i] = i;
+  typedOut_.build(outOffsets_, outEdgeIndices, records_);
+  typedIn_.build(inOffsets_, inEdgeIndices_, records_);
+
+  std::map<DepType, size_t> counts;
+  foreach (const EdgeRecord &r, records_)
+    counts[r.type]++;
+  typeCounts_.assign(counts.begin(), counts.end());
+}
+
+void DepGraphSnapshot::TypedIndex::build(const std::vector<size_t> &edgeOffsets,
+                                         const std::vector<size_t> &edgeIds,
+                                         const std::vector<EdgeRecord> &records)
+{
+  ids = edgeIds;
+  runs.clear();
+  offsets.assign(1, 0);
+  for (size_t v = 0; v + 1 < edgeOffsets.size(); v++) {
+    size_t begin = edgeOffsets[v],
+           end = edgeOffsets[v + 1];
+    std::stable_sort(ids.begin() + begin, ids.begin() + end, EdgeTypeLess(records));
+    for (size_t i = begin; i < end; i++)
+      if (i == begin || records[ids[i]].type != runs.back().type) {
+        Run r;
+        r.type = records[ids[i]].type;
+        r.begin = i;
+        r.end = i + 1;
+        runs.push_back(r);
+      } else
+        runs.back().end++;
+    offsets.push_back(runs.size());
+  }
+}
+
+size_t DepGraphSnapshot::num_edges(int mask) const
+{
+  size_t ret = 0;
+  foreach (const type_count_list::value_type &p, typeCounts_)
+    if (p.first & mask)
+      ret += p.second;
+  return ret;
+}
+
+size_t DepGraphSnapshot::find(const SgNode *stmt) const
+{
+  BOOST_AUTO(p, statementIndices_.find(stmt));
+  return p == statementIndices_.end() ? npos : p->second;
+}
+
+std::pair<DepGraphSnapshot::edge_iterator, DepGraphSnapshot::edge_iterator>
+DepGraphSnapshot::edges_between(size_t u, size_t v) const
+{
+  BOOST_AUTO(p, pairIndices_.find(std::make_pair(u, v)));
+  return p == pairIndices_.end() ? no_edges() :
+         std::make_pair(outEdges_.begin() + p->second.first, outEdges_.begin() + p->second.second);
+}
+
 // - Graph constructions -
 
 bool DepGraph::init(SgNode *root, const option_type *option)
 {
   D *d = nullptr;
+  bool compactEdges = option && option->compactEdges && compactible();
   if (root) {
     d = new D(option);
+    // Demanded edges are compared with the ones computed before
+    d->graph.setCompactEdges(compactEdges && !option->demand);
     if (!d->build(root)) {
       delete d;
       d = nullptr;
     }
   }
   d_.reset(d);
-  return d_;
+  if (!d)
+    return false;
+
+  // The ROSE graph is not modified after build
+  d->data->snapshot.build(d->graph);
+  for (size_t i = 0; i < d->data->snapshot.num_vertices(); i++)
+    d->data->indices[d->data->snapshot.vertex(i)] = i;
+  if (compactEdges)
+    compact();
+  return true;
+}
+
+bool DepGraph::compact()
+{
+  if (!valid() || !compactible())
+    return false;
+  if (!d_->data->compacted) {
+    d_->graph.compact();
+    d_->data->compacted = true;
+  }
+  return true;
+}
+
+bool DepGraph::compacted() const
+{ return valid() && d_->data->compacted; }
+
+const DepGraph::snapshot_type &DepGraph::snapshot() const
+{
+  ROSE_ASSERT(valid());
+  return d_->data->snapshot;
 }
 
 void DepGraph::toDOT(const std::string &filename, const std::string &graphname) const
@@ -202,18 +371,16 @@ void DepGraph::toDOT(const std::string &filename, const std::string &graphname)
       .writeToDOTFile(filename, graphname);
 }
 
+bool DepGraph::save(const std::string &filename) const
+{ return DepGraphFile::write(filename, *this); }
+
 // - Graph properties -
 
 DepGraph::vertex_type DepGraph::find(const SgNode *stmt) const
 {
-  ROSE_ASSERT(valid());
-
-  if (stmt)
-    foreach (const vertex_type &v, vertices())
-      if (v && v.statement() == stmt)
-        return v;
-
-  return null_vertex();
+  const snapshot_type &s = snapshot();
+  size_t i = stmt ? s.find(stmt) : snapshot_type::npos;
+  return i == snapshot_type::npos ? null_vertex() : s.vertex(i);
 }
 
 bool DepGraph::contains(vertex_type v) const
@@ -227,44 +394,77 @@ bool DepGraph::contains(edge_type e) const
 
 bool DepGraph::contains(vertex_type u, vertex_type v) const
 {
-  ROSE_ASSERT(valid());
+  std::pair<out_edge_iterator, out_edge_iterator> r = edges_between(u, v);
+  return r.first != r.second;
+}
 
-  if (u && v)
-    foreach (const edge_type &e, out_edges(u))
-      if (target(e) == v)
-        return true;
-  return false;
+std::pair<DepGraph::out_edge_iterator, DepGraph::out_edge_iterator>
+DepGraph::edges_between(vertex_type u, vertex_type v) const
+{
+  const snapshot_type &s = snapshot();
+  size_t i = s.index(u),
+         j = s.index(v);
+  return i == snapshot_type::npos || j == snapshot_type::npos ? s.no_edges() : s.edges_between(i, j);
 }
 
-DepGraph::vertex_iterator DepGraph::vertices_begin() const
+// - Loops -
+
+bool DepGraph::encloses(const SgNode *loop, vertex_type v) const
+{
+  ROSE_ASSERT(valid());
+  return v && d_->graph.loopNest().encloses(loop, v.statement());
+}
+
+const SgNode *DepGraph::commonLoop(vertex_type u, vertex_type v) const
 {
   ROSE_ASSERT(valid());
-  return d_->graph.GetNodeIterator();
+  return u && v ? d_->graph.loopNest().commonLoop(u.statement(), v.statement()) : nullptr;
 }
 
+bool DepGraph::isAnalyzedLoop(const SgNode *loop) const
+{ return valid() && loop && d_->graph.loopNode(loop); }
+
+size_t DepGraph::num_loops() const
+{ return valid() ? d_->graph.loopNodes().size() : 0; }
+
+size_t DepGraph::num_loop_edges() const
+{ return valid() ? d_->graph.edgeStatistics().loops : 0; }
+
+DepGraph::vertex_iterator DepGraph::vertices_begin() const
+{ return snapshot().vertices().first; }
+
 DepGraph::vertex_iterator DepGraph::vertices_end() const
-{ return vertex_iterator(); }
+{ return snapshot().vertices().second; }
 
+// Vertices not in the graph have no edges
 
 DepGraph::in_edge_iterator DepGraph::in_edges_begin(vertex_type v) const
 {
-  ROSE_ASSERT(valid());
-  return v ? in_edge_iterator(d_->graph.GetNodeEdgeIterator(v, GraphAccess::EdgeIn))
-           : in_edge_iterator();
+  const snapshot_type &s = snapshot();
+  size_t i = s.index(v);
+  return i == snapshot_type::npos ? s.no_edges().first : s.in_edges(i).first;
 }
 
 DepGraph::in_edge_iterator DepGraph::in_edges_end(vertex_type v) const
-{ return in_edge_iterator(); }
+{
+  const snapshot_type &s = snapshot();
+  size_t i = s.index(v);
+  return i == snapshot_type::npos ? s.no_edges().second : s.in_edges(i).second;
+}
 
 DepGraph::out_edge_iterator DepGraph::out_edges_begin(vertex_type v) const
 {
-  ROSE_ASSERT(valid());
-  return v ? out_edge_iterator(d_->graph.GetNodeEdgeIterator(v, GraphAccess::EdgeOut))
-           : out_edge_iterator();
+  const snapshot_type &s = snapshot();
+  size_t i = s.index(v);
+  return i == snapshot_type::npos ? s.no_edges().first : s.out_edges(i).first;
 }
 
 DepGraph::out_edge_iterator DepGraph::out_edges_end(vertex_type v) const
-{ return out_edge_iterator(); }
+{
+  const snapshot_type &s = snapshot();
+  size_t i = s.index(v);
+  return i == snapshot_type::npos ? s.no_edges().second : s.out_edges(i).second;
+}
 
 DepGraph::vertex_type DepGraph::source(edge_type e) const
 {
@@ -280,93 +480,106 @@ DepGraph::vertex_type DepGraph::target(edge_type e) const
            : null_vertex();
 }
 
-// TODO jichi 6/24/2011: Hack the VirtualGraphCreate to directly get the number
-// rather than counting manually.
-
 size_t DepGraph::in_degree(vertex_type v) const
 {
-  ROSE_ASSERT(valid());
-  return count(in_edges(v));
+  const snapshot_type &s = snapshot();
+  size_t i = s.index(v);
+  return i == snapshot_type::npos ? 0 : s.in_degree(i);
 }
 
 size_t DepGraph::out_degree(vertex_type v) const
 {
-  ROSE_ASSERT(valid());
-  return count(out_edges(v));
+  const snapshot_type &s = snapshot();
+  size_t i = s.index(v);
+  return i == snapshot_type::npos ? 0 : s.out_degree(i);
 }
 
-size_t DepGraph::num_vertices() const
+std::pair<DepGraph::typed_edge_iterator, DepGraph::typed_edge_iterator>
+DepGraph::out_edges(vertex_type v, int mask) const
 {
-  ROSE_ASSERT(valid());
-  return count(vertices());
+  const snapshot_type &s = snapshot();
+  size_t i = s.index(v);
+  return i == snapshot_type::npos ? std::make_pair(typed_edge_iterator(), typed_edge_iterator()) :
+         s.out_edges(i, mask);
 }
 
-size_t DepGraph::num_edges() const
+std::pair<DepGraph::typed_edge_iterator, DepGraph::typed_edge_iterator>
+DepGraph::in_edges(vertex_type v, int mask) const
 {
-  ROSE_ASSERT(valid());
+  const snapshot_type &s = snapshot();
+  size_t i = s.index(v);
+  return i == snapshot_type::npos ? std::make_pair(typed_edge_iterator(), typed_edge_iterator()) :
+         s.in_edges(i, mask);
+}
 
-  size_t ret = 0;
-  foreach (const vertex_type &v,    vertices())
-    ret += out_degree(v);
+size_t DepGraph::num_duplicate_edges() const
+{ return valid() ? d_->graph.edgeStatistics().duplicates : 0; }
 
-  return ret;
-}
+size_t DepGraph::num_array_tests() const
+{ return valid() ? d_->graph.testStatistics().tests : 0; }
 
-std::pair<
-  DepGraph::edge_iterator,
-  DepGraph::edge_iterator
-  >
-DepGraph::edges() const
-{
-  ROSE_ASSERT(valid() && d_->data);
+size_t DepGraph::num_cached_array_tests() const
+{ return valid() ? d_->graph.testStatistics().hits : 0; }
 
-  BOOST_AUTO(p, d_->data->p_edges.get());
-  if (!p) {
-    p = new typeof(*p);
+size_t DepGraph::num_uncacheable_array_tests() const
+{ return valid() ? d_->graph.testStatistics().uncached : 0; }
 
-    foreach (const vertex_type &v, vertices())
-      boost::copy(out_edges(v), std::back_inserter(*p));
+size_t DepGraph::num_filtered_array_tests() const
+{ return valid() ? d_->graph.testStatistics().filtered : 0; }
 
-    d_->data->p_edges.reset(p);
-  }
+size_t DepGraph::num_mismatched_array_tests() const
+{ return valid() ? d_->graph.testStatistics().mismatches : 0; }
 
-  return std::make_pair(p->begin(), p->end());
-}
+size_t DepGraph::num_exact_array_tests() const
+{ return valid() ? d_->graph.testStatistics().exact : 0; }
 
-bool DepGraph::has_edges() const
-{
-  ROSE_ASSERT(valid());
+size_t DepGraph::num_mismatched_exact_tests() const
+{ return valid() ? d_->graph.testStatistics().exactMismatches : 0; }
 
-  foreach (const vertex_type &v, vertices())
-    if (has_out_edges(v))
-      return true;
-  return false;
-}
+size_t DepGraph::num_deferred_array_tests() const
+{ return valid() ? d_->graph.testStatistics().deferred : 0; }
+
+size_t DepGraph::num_demanded_pairs() const
+{ return valid() ? d_->graph.testStatistics().demandedPairs : 0; }
+
+size_t DepGraph::num_allocations() const
+{ return valid() ? d_->graph.allocationStatistics().allocations : 0; }
+
+size_t DepGraph::num_heap_allocations() const
+{ return valid() ? d_->graph.allocationStatistics().heap : 0; }
+
+size_t DepGraph::allocated_bytes() const
+{ return valid() ? d_->graph.allocationStatistics().bytes : 0; }
+
+size_t DepGraph::num_edge_payloads() const
+{ return valid() ? d_->graph.allocationStatistics().payloads : 0; }
+
+size_t DepGraph::num_edge_relations() const
+{ return valid() ? d_->graph.allocationStatistics().relations : 0; }
+
+size_t DepGraph::num_vertices() const
+{ return snapshot().num_vertices(); }
+
+size_t DepGraph::num_edges() const
+{ return snapshot().num_edges(); }
+
+std::pair<
+  DepGraph::edge_iterator,
+  DepGraph::edge_iterator
+  >
+DepGraph::edges() const
+{ return snapshot().edges(); }
 
 boost::associative_property_map<
   boost::unordered_map<DepGraph::vertex_type, int>
   >
 DepGraph::indices() const
 {
-  #define SELF indices
-  typedef typeof(SELF()) RETURN;
-
   ROSE_ASSERT(valid());
-
-  BOOST_AUTO(alloc, d_->data->p_indices.get());
-  if (!alloc) {
-    alloc = new typeof(*alloc);
-    d_->data->p_indices.reset(alloc);
-  }
-
-  RETURN indices(*alloc);
-
-  int index = 0;
-  foreach (const vertex_type &v, vertices())
-    indices[v] = index++;
-  return indices;
-
-  #undef SELF
+  // Numbered with the snapshot
+  return boost::associative_property_map<
+    boost::unordered_map<vertex_type, int>
+  >(d_->data->indices);
 }
 
 // - Conversions -
@@ -23,6 +23,8 @@
 #include "rosex/rosex.h"
 #include "rosex/depgraph_p.h"
 #include <boost/foreach.hpp>
+#include <boost/function.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/properties.hpp>
@@ -36,6 +38,8 @@
 
 #include <iterator>
 #include <string>
+#include <utility>
+#include <vector>
 
 class SgNode;
 
@@ -73,26 +77,112 @@ std::string DepType2String( DepType t);
  *  - funcInfo      Function side effect
  *  - stmtInfo      Statement side effect
  *  - arrayInfo     Array interface
+ *  - regionThreads Threads to build the top-level regions of a function
+ *  - memoTests     Memoize array dependence tests across graphs
+ *  - filterTests   Prove independence by cheap tests before ROSE
+ *  - verifyTests   Also compare the filtered tests with ROSE, implying filterTests
+ *  - exactTests    Decide affine references by integer sets instead of ROSE
+ *  - verifyExactTests  Also compare the exact tests with ROSE, implying exactTests
+ *  - budget        Time and memory limits of the build, not owned
+ *  - demand        Seed predicate to only build the dependences reaching it
+ *  - arena         Allocate vertices and edges in blocks owned by the graph
+ *  - compactEdges  Only keep the records of the edges, see DepGraph::compact
  *
  *  The default value is nothing.
+ *
+ *  If regionThreads is more than 1, the top-level statements of the body of a
+ *  function definition are built as separate regions concurrently, and only
+ *  the data dependences between different regions are computed afterwards
+ *  in a single thread. The whole function is built at once instead if there
+ *  is only one region, or any region other than the last contains jumps,
+ *  labels, or I/O, whose dependences could cross the regions other than
+ *  through data.
+ *
+ *  If memoTests is set, array dependence tests are cached by a canonical form
+ *  of the two references and their enclosing loop headers, with variables
+ *  renamed by first occurrence. The cache is shared by the graphs of all
+ *  functions in the process without aliasInfo, funcInfo, and arrayInfo, so
+ *  that repeated subscript patterns such as unrolled statements or similar
+ *  kernels are only tested once. A graph with any of these interfaces only
+ *  reuses its own tests.
+ *
+ *  If filterTests is set, distinct arrays and affine subscripts disproven by
+ *  the GCD or Banerjee bounds tests are reported independent without ROSE.
+ *  The filter only answers for independence, so the graph is expected to be
+ *  the same as without it, which verifyTests checks test by test.
+ *
+ *  If exactTests is set, references to the same array with affine subscripts
+ *  in canonical loops are tested by Fourier-Motzkin elimination over the
+ *  integers. The edges then have exact distances between their loops, rather
+ *  than the conservative directions of ROSE, whenever the elimination is
+ *  exact. Other references are still tested by ROSE. If verifyExactTests is
+ *  set, ROSE is also run for the dependent answers, which must be within the
+ *  relations of ROSE, so that the sign and alignment conventions are checked.
+ *
+ *  If budget is set, it is checked at each array dependence test and each
+ *  edge, and the graph is not valid if the budget is exceeded during build.
+ *
+ *  If demand is set, the array dependence tests are first deferred while the
+ *  vertices and the other dependences are built. The tests are then only run
+ *  for the statement pairs involving a demanded statement, which initially
+ *  are the statements containing an expression satisfying the predicate. The
+ *  source statements of the data dependences into a demanded statement are
+ *  demanded as well, until fixpoint. The graph then contains every edge that
+ *  a backward slice from the predicate could visit, as in DepSlice, so that
+ *  the slice is the same as of the full graph. Other array dependences are
+ *  missing, and regionThreads is ignored.
+ *
+ *  If arena is set, the vertices and edges are carved from blocks owned by the
+ *  graph, and the blocks are released at once with the graph. Otherwise, they
+ *  are allocated by the global operator new as by ROSE. The DepInfo of the
+ *  edges and the DomainCond of the vertices, which are most of the memory of
+ *  a large graph, are not pooled either way, as ROSE allocates them one by one
+ *  inside its reference-counted handles; compactEdges releases the loop
+ *  relations of the DepInfo instead. The loop relations of the edges are
+ *  counted by num_edge_payloads(), so that the allocations left to ROSE
+ *  could be compared with those of the arena.
+ *
+ *  If compactEdges is set, the data dependences are compacted as they are
+ *  created, and the rest of the graph once built, so that the loop relations
+ *  of the data dependences, which are most of the edges, never accumulate.
+ *  It is ignored by graphs that could not be compacted, such as LoopDepGraph.
+ *
+ *  Graphs could be built by different threads. Graphs with the same alias,
+ *  side effect, and array interfaces are built concurrently, while a graph
+ *  with different ones waits for the others to finish.
  */
 class AliasAnalysisInterface;
 class FunctionSideEffectInterface;
 class ArrayAbstractionInterface;
 class SideEffectAnalysisInterface;
+class AnalysisBudget;
 struct DepGraphOption
 {
+  typedef boost::function<bool (const SgNode *)> predicate_type;
+
   AliasAnalysisInterface        *aliasInfo;
   FunctionSideEffectInterface   *funcInfo;
   SideEffectAnalysisInterface   *stmtInfo;
   ArrayAbstractionInterface     *arrayInfo;
+  int regionThreads;
+  bool memoTests,
+       filterTests,
+       verifyTests,
+       exactTests,
+       verifyExactTests,
+       arena,
+       compactEdges;
+  const AnalysisBudget *budget;
+  predicate_type demand;
 
   explicit DepGraphOption(
       AliasAnalysisInterface        *alias = nullptr,
       FunctionSideEffectInterface   *func = nullptr,
       SideEffectAnalysisInterface   *stmt = nullptr,
       ArrayAbstractionInterface     *array = nullptr)
-    : aliasInfo(alias), funcInfo(func), stmtInfo(stmt), arrayInfo(array) { }
+    : aliasInfo(alias), funcInfo(func), stmtInfo(stmt), arrayInfo(array), regionThreads(0),
+      memoTests(false), filterTests(false), verifyTests(false), exactTests(false),
+      verifyExactTests(false), arena(false), compactEdges(false), budget(nullptr) { }
 };
 
 //class FunctionSideEffect : public FunctionSideEffectInterface
@@ -275,6 +365,250 @@ public:
   SgNode *targetExpression() const;
 };
 
+///  Hash the underlying pointer, used by boost::unordered containers.
+inline size_t hash_value(const DepGraphVertex &v) { return boost::hash_value(v.data()); }
+inline size_t hash_value(const DepGraphEdge &e) { return boost::hash_value(e.data()); }
+
+// DepGraphTypedEdgeIterator
+/**
+ *  \brief  Const forward iterator over the edges of selected dependency types.
+ *
+ *  Returned by DepGraph::out_edges(v, mask) and DepGraph::in_edges(v, mask).
+ *  The edges of a vertex are partitioned into runs of the same DepType, and
+ *  the runs whose types do not intersect the mask are skipped as a whole.
+ */
+class DepGraphTypedEdgeIterator
+{
+  typedef DepGraphTypedEdgeIterator Self;
+
+public:
+  ///  Edges of the same type, which are ids[begin, end).
+  struct Run {
+    int type;
+    size_t begin, end;
+  };
+
+  // Consistent with std::iterator_traits<Self>
+  typedef ptrdiff_t       difference_type;
+  typedef DepGraphEdge    value_type;
+  typedef const value_type* pointer;
+  typedef const value_type &reference;
+
+  typedef std::forward_iterator_tag iterator_category;
+
+public:
+  ///  Create an empty iterator.
+  DepGraphTypedEdgeIterator()
+    : run_(nullptr), runEnd_(nullptr), pos_(0), mask_(0), ids_(nullptr), edges_(nullptr) { }
+
+  ///  \internal
+  DepGraphTypedEdgeIterator(const Run *run, const Run *runEnd, int mask,
+                            const size_t *ids, const value_type *edges)
+    : run_(run), runEnd_(runEnd), pos_(0), mask_(mask), ids_(ids), edges_(edges)
+  { seek(); }
+
+  reference operator*() const { return edges_[ids_[pos_]]; }
+  pointer operator->() const { return &edges_[ids_[pos_]]; }
+
+  Self &operator++()
+  {
+    if (++pos_ == run_->end) {
+      ++run_;
+      seek();
+    }
+    return *this;
+  }
+  Self operator++(int) { Self t = *this; operator++(); return t; }
+  bool operator==(const Self &that) const { return run_ == that.run_ && pos_ == that.pos_; }
+  bool operator!=(const Self &that) const { return !operator==(that); }
+
+private:
+  ///  Move to the first edge of the next selected run, or the end.
+  void seek()
+  {
+    while (run_ != runEnd_ && !(run_->type & mask_))
+      ++run_;
+    pos_ = run_ == runEnd_ ? 0 : run_->begin;
+  }
+
+  const Run *run_, *runEnd_;
+  size_t pos_;
+  int mask_;
+  const size_t *ids_;
+  const value_type *edges_;
+};
+
+// DepGraphSnapshot
+/**
+ *  \brief  Immutable compressed-sparse-row copy of the dependency graph.
+ *
+ *  Taken once after the graph is built, and returned by DepGraph::snapshot().
+ *  Vertices are numbered from 0 in the order of DepGraph::vertices, and edges
+ *  are numbered from 0 grouped by their source vertices, so that the out-edges
+ *  of a vertex are contiguous. The in-edges are contiguous in a separate array.
+ *  The out-edges of a vertex are ordered by their targets, so that parallel
+ *  edges are contiguous as well.
+ *
+ *  All ranges are random access, and counts and degrees are O(1). Vertices of
+ *  statements and edges between two vertices are found in O(1) expected time.
+ *
+ *  The in- and out-edges of each vertex are also partitioned by DepType, so
+ *  that the edges of selected types are traversed without visiting others.
+ */
+class DepGraphSnapshot
+{
+  friend class DepGraph;
+  typedef DepGraphSnapshot Self;
+
+public:
+  typedef DepGraphVertex  vertex_type;
+  typedef DepGraphEdge    edge_type;
+
+  ///  Properties of an edge cached out of DepInfo.
+  struct EdgeRecord {
+    size_t source,  ///< vertex number
+           target;  ///< vertex number
+    DepType type;
+    SgNode *sourceExpression,
+           *targetExpression;
+  };
+
+  typedef std::vector<vertex_type>::const_iterator vertex_iterator;
+  typedef std::vector<edge_type>::const_iterator   edge_iterator;
+  typedef std::vector<size_t>::const_iterator      edge_index_iterator;
+  typedef DepGraphTypedEdgeIterator                typed_edge_iterator;
+
+  ///  Number of edges of each type in the order of types.
+  typedef std::vector<std::pair<DepType, size_t> > type_count_list;
+
+  static const size_t npos = size_t(-1);
+
+  // - Counts -
+public:
+  size_t num_vertices() const { return vertices_.size(); }
+  size_t num_edges() const { return outEdges_.size(); }
+
+  size_t out_degree(size_t v) const { return outOffsets_[v + 1] - outOffsets_[v]; }
+  size_t in_degree(size_t v) const { return inOffsets_[v + 1] - inOffsets_[v]; }
+
+  // - Numbering -
+public:
+  ///  Return the number of the vertex, or npos if not in the graph.
+  size_t index(vertex_type v) const;
+  ///  Return the number of the edge, or npos if not in the graph.
+  size_t index(edge_type e) const;
+
+  ///  Return the number of the first vertex of the statement, or npos if not found.
+  size_t find(const SgNode *stmt) const;
+
+  vertex_type vertex(size_t v) const { return vertices_[v]; }
+  edge_type edge(size_t e) const { return outEdges_[e]; }
+  const EdgeRecord &record(size_t e) const { return records_[e]; }
+
+  // - Ranges -
+public:
+  std::pair<vertex_iterator, vertex_iterator> vertices() const
+  { return std::make_pair(vertices_.begin(), vertices_.end()); }
+
+  ///  All edges in the order of their numbers.
+  std::pair<edge_iterator, edge_iterator> edges() const
+  { return std::make_pair(outEdges_.begin(), outEdges_.end()); }
+
+  std::pair<edge_iterator, edge_iterator> out_edges(size_t v) const
+  { return std::make_pair(outEdges_.begin() + outOffsets_[v], outEdges_.begin() + outOffsets_[v + 1]); }
+
+  std::pair<edge_iterator, edge_iterator> in_edges(size_t v) const
+  { return std::make_pair(inEdges_.begin() + inOffsets_[v], inEdges_.begin() + inOffsets_[v + 1]); }
+
+  ///  Numbers of the out-edges of \p v, which are [begin, end).
+  std::pair<size_t, size_t> out_edge_indices(size_t v) const
+  { return std::make_pair(outOffsets_[v], outOffsets_[v + 1]); }
+
+  ///  Numbers of the in-edges of \p v.
+  std::pair<edge_index_iterator, edge_index_iterator> in_edge_indices(size_t v) const
+  { return std::make_pair(inEdgeIndices_.begin() + inOffsets_[v], inEdgeIndices_.begin() + inOffsets_[v + 1]); }
+
+  ///  Edges from \p u to \p v.
+  std::pair<edge_iterator, edge_iterator> edges_between(size_t u, size_t v) const;
+
+  ///  An empty range, used for vertices not in the graph.
+  std::pair<edge_iterator, edge_iterator> no_edges() const
+  { return std::make_pair(outEdges_.end(), outEdges_.end()); }
+
+  // - Dependency types -
+public:
+  ///  Out-edges of \p v whose types intersect \p mask, such as DEPTYPE_TRUE|DEPTYPE_CTRL.
+  std::pair<typed_edge_iterator, typed_edge_iterator> out_edges(size_t v, int mask) const
+  { return typedOut_.edges(v, mask, outEdges_); }
+
+  ///  In-edges of \p v whose types intersect \p mask.
+  std::pair<typed_edge_iterator, typed_edge_iterator> in_edges(size_t v, int mask) const
+  { return typedIn_.edges(v, mask, outEdges_); }
+
+  size_t out_degree(size_t v, int mask) const { return typedOut_.count(v, mask); }
+  size_t in_degree(size_t v, int mask) const { return typedIn_.count(v, mask); }
+
+  ///  Number of edges whose types intersect \p mask.
+  size_t num_edges(int mask) const;
+
+  const type_count_list &type_counts() const { return typeCounts_; }
+
+private:
+  typedef DepGraphTypedEdgeIterator::Run Run;
+
+  ///  Edges of each vertex partitioned by types.
+  struct TypedIndex {
+    std::vector<size_t> offsets; // runs of v are [offsets[v], offsets[v+1])
+    std::vector<Run> runs;
+    std::vector<size_t> ids;     // edge numbers
+
+    void build(const std::vector<size_t> &edgeOffsets, const std::vector<size_t> &edgeIds,
+               const std::vector<EdgeRecord> &records);
+
+    std::pair<typed_edge_iterator, typed_edge_iterator>
+    edges(size_t v, int mask, const std::vector<edge_type> &l) const
+    {
+      const Run *r = runs.empty() ? nullptr : &runs[0];
+      const size_t *i = ids.empty() ? nullptr : &ids[0];
+      const edge_type *e = l.empty() ? nullptr : &l[0];
+      return std::make_pair(
+        typed_edge_iterator(r + offsets[v], r + offsets[v + 1], mask, i, e),
+        typed_edge_iterator(r + offsets[v + 1], r + offsets[v + 1], mask, i, e));
+    }
+
+    size_t count(size_t v, int mask) const
+    {
+      size_t ret = 0;
+      for (size_t i = offsets[v]; i < offsets[v + 1]; i++)
+        if (runs[i].type & mask)
+          ret += runs[i].end - runs[i].begin;
+      return ret;
+    }
+  };
+
+  void build(DepGraphPrivate::Graph &g);
+
+  std::vector<vertex_type> vertices_;
+  boost::unordered_map<vertex_type, size_t> vertexIndices_;
+  boost::unordered_map<edge_type, size_t> edgeIndices_;
+  boost::unordered_map<const SgNode *, size_t> statementIndices_;
+  boost::unordered_map<
+    std::pair<size_t, size_t>,  // (source, target)
+    std::pair<size_t, size_t>   // numbers of edges [first, second)
+  > pairIndices_;
+
+  std::vector<size_t> outOffsets_,    // out-edges of v are [outOffsets_[v], outOffsets_[v+1])
+                      inOffsets_;     // in-edges of v are [inOffsets_[v], inOffsets_[v+1])
+  std::vector<edge_type> outEdges_,   // numbered edges
+                         inEdges_;    // grouped by targets
+  std::vector<size_t> inEdgeIndices_; // numbers of inEdges_
+  std::vector<EdgeRecord> records_;   // by edge numbers
+
+  TypedIndex typedOut_,
+             typedIn_;
+  type_count_list typeCounts_;
+};
+
 // DepGraphVertexItertor
 /**
  *  \brief  Const forward iterator for traversing vertices in DepGraph
@@ -412,8 +746,8 @@ public:
  *  Types:
  *  - vertex_type     holding immutable vertex, see DepGraphVertex
  *  - edge_type       holding immutable edge, see DepGraphEdge
- *  - vertex_iterator   const forward iterator, see DepGraphVertexIterator
- *  - edge_iterator   const forward iterator, see DepGraphEdgeIterator
+ *  - vertex_iterator   const random access iterator, see DepGraphSnapshot
+ *  - edge_iterator   const random access iterator, see DepGraphSnapshot
  *
  *  In the current implementation, vertex_type and edge_type are just
  *  only holding pointers to the underlying implementation.
@@ -450,10 +784,14 @@ public:
 
   typedef DepGraphVertex        vertex_type;
   typedef DepGraphEdge        edge_type;
-  typedef DepGraphVertexIterator    vertex_iterator;
-  typedef DepGraphEdgeIterator    in_edge_iterator;
+  typedef DepGraphSnapshot    snapshot_type;
+
+  // Random access iterators of the snapshot
+  typedef snapshot_type::vertex_iterator  vertex_iterator;
+  typedef snapshot_type::edge_iterator    in_edge_iterator;
   typedef in_edge_iterator      out_edge_iterator;
-  typedef std::list<edge_type>::iterator  edge_iterator;
+  typedef snapshot_type::edge_iterator    edge_iterator;
+  typedef snapshot_type::typed_edge_iterator typed_edge_iterator;
 
   static vertex_type null_vertex()  { return vertex_type(); }
   static edge_type   null_edge()  { return edge_type(); }
@@ -499,9 +837,35 @@ public:
   ///  True if the instance is holding a valid implementation.
   bool valid() const { return d_; }
 
+  /**
+   *  \brief  Release the loop relations of the edges and the vertices.
+   *
+   *  Only the type, the end points, the expressions, and the common loop
+   *  level of each edge are kept, which are the properties in the records of
+   *  the snapshot, together with the cached properties of the vertices. The
+   *  graph could still be traversed, but depInfo() of edges has no rows or
+   *  columns, depInfo() of vertices is empty, and save() writes no relations.
+   *  The graph is compacted in place, and is shared by the graphs copied from
+   *  it as well.
+   *
+   *  \return  false if the graph is not valid or could not be compacted
+   */
+  bool compact();
+
+  ///  If compact() has been called.
+  bool compacted() const;
+
+protected:
+  ///  If the graph could be compacted, false if its loop relations are read after build.
+  virtual bool compactible() const { return true; }
+
+public:
   ///  Output the graph to DOT format.
   void toDOT(const std::string &filename, const std::string &graphname = "DepGraph") const;
 
+  ///  Output the graph to the binary format of DepGraphFile. Return false if failed.
+  bool save(const std::string &filename) const;
+
   ///  Output the graph to plain text.
   template <typename OutputStream>
   inline void dump(OutputStream &out) const;
@@ -521,6 +885,9 @@ public:
   ///  \internal Only for debug use. Return the implementation.
   D *data() const { return d_.get(); }
 
+  ///  Compressed-sparse-row copy taken after the graph is built.
+  const snapshot_type &snapshot() const;
+
   ///  \internal  Reset the implementation.
   void reset(D *d = nullptr) { d_.reset(d); }
 
@@ -534,7 +901,7 @@ public:
 public:
   ///  Return the first vertex in the graph.
   vertex_type entry() const
-  { return valid()? *vertices_begin() : null_vertex(); }
+  { return valid() && has_vertices() ? *vertices_begin() : null_vertex(); }
 
   ///  Return the vertex in the dependency graph, or null_vertex if not exist
   vertex_type find(const SgNode *stmt) const;
@@ -551,6 +918,9 @@ public:
   bool contains(std::pair<vertex_type, vertex_type> e) const
   { return contains(e.first, e.second); }
 
+  ///  Return (begin, end) pair to traverse the edges from \p u to \p v
+  std::pair<out_edge_iterator, out_edge_iterator> edges_between(vertex_type u, vertex_type v) const;
+
   ///  Return (begin, end) pair to traverse all vertices in the graph
   std::pair<vertex_iterator, vertex_iterator> vertices() const
   { return std::make_pair(vertices_begin(), vertices_end()); }
@@ -578,9 +948,15 @@ public:
   ///  End of out-edges
   out_edge_iterator out_edges_end(vertex_type v) const;
 
-  ///  Return all edges, expensive to compute.
+  ///  Return all edges in the order of the snapshot.
   std::pair<edge_iterator, edge_iterator> edges() const;
 
+  ///  Return (begin, end) pair to traverse out-edges of \p v whose types intersect \p mask
+  std::pair<typed_edge_iterator, typed_edge_iterator> out_edges(vertex_type v, int mask) const;
+
+  ///  Return (begin, end) pair to traverse in-edges of \p v whose types intersect \p mask
+  std::pair<typed_edge_iterator, typed_edge_iterator> in_edges(vertex_type v, int mask) const;
+
   ///  Source vertex of the edge \p e.
   vertex_type source(edge_type e) const;
   ///  Target vertex of edge \p e.
@@ -595,17 +971,74 @@ public:
   size_t num_vertices() const;
   ///  Total number of edges, or 0 for bad graph.
   size_t num_edges() const;
-
-  bool has_vertices() const { return vertices_begin(); }
-  bool has_in_edges(vertex_type v) const { return in_edges_begin(v); }
-  bool has_out_edges(vertex_type v) const { return out_edges_begin(v); }
-  bool has_edges() const;
+  ///  Number of edges whose types intersect \p mask.
+  size_t num_edges(int mask) const { return snapshot().num_edges(mask); }
+  ///  Number of edges of each type.
+  const snapshot_type::type_count_list &edge_type_counts() const { return snapshot().type_counts(); }
+  ///  Number of duplicate transitive edges not created when building the graph.
+  size_t num_duplicate_edges() const;
+  ///  Number of array dependence tests when building the graph.
+  size_t num_array_tests() const;
+  ///  Number of array dependence tests answered by the cache.
+  size_t num_cached_array_tests() const;
+  ///  Number of array dependence tests that could not be cached.
+  size_t num_uncacheable_array_tests() const;
+  ///  Number of array dependence tests proven independent by the filter.
+  size_t num_filtered_array_tests() const;
+  ///  Number of filtered tests reported dependent by ROSE, if DepGraphOption::verifyTests.
+  size_t num_mismatched_array_tests() const;
+  ///  Number of array dependence tests answered by the integer set test, if DepGraphOption::exactTests.
+  size_t num_exact_array_tests() const;
+  ///  Number of exact tests inconsistent with ROSE, if DepGraphOption::verifyExactTests.
+  size_t num_mismatched_exact_tests() const;
+  ///  Number of array dependence tests deferred, if DepGraphOption::demand.
+  size_t num_deferred_array_tests() const;
+  ///  Number of statement pairs of the deferred tests computed on demand, if DepGraphOption::demand.
+  size_t num_demanded_pairs() const;
+  ///  Number of vertices and edges allocated when building the graph, including the removed ones.
+  size_t num_allocations() const;
+  ///  Number of heap allocations for the vertices and edges, which are arena blocks if DepGraphOption::arena.
+  size_t num_heap_allocations() const;
+  ///  Bytes of the heap allocations for the vertices and edges.
+  size_t allocated_bytes() const;
+  ///  Number of edges created with loop relations, whose DepInfo is allocated by ROSE rather than the arena.
+  size_t num_edge_payloads() const;
+  ///  Number of loop relations in the DepInfo of these edges.
+  size_t num_edge_relations() const;
+
+  bool has_vertices() const { return num_vertices(); }
+  bool has_in_edges(vertex_type v) const { return in_degree(v); }
+  bool has_out_edges(vertex_type v) const { return out_degree(v); }
+  bool has_edges() const { return num_edges(); }
 
   ///  Return indices of vertex
   boost::associative_property_map<
   boost::unordered_map<vertex_type, int>
   >
   indices() const;
+
+  // - Loops -
+  /**
+   *  \name  Loops
+   *
+   *  Loops enclosing the vertices, annotated when the graph is built.
+   *  The analyzed loop headers are kept aside rather than as vertices.
+   */
+public:
+  ///  Return if the statement of \p v is \p loop or inside \p loop.
+  bool encloses(const SgNode *loop, vertex_type v) const;
+
+  ///  Innermost loop enclosing the statements of both vertices, or nullptr.
+  const SgNode *commonLoop(vertex_type u, vertex_type v) const;
+
+  ///  Return if \p loop was analyzed as a loop header when building the graph.
+  bool isAnalyzedLoop(const SgNode *loop) const;
+
+  ///  Number of loop headers analyzed.
+  size_t num_loops() const;
+
+  ///  Number of dependences of loop headers, which are not created as edges.
+  size_t num_loop_edges() const;
 };
 
 // DepGraphPropertiesWriter
@@ -666,6 +1099,10 @@ namespace boost {
   typedef DepGraph G;
 
   typedef G::directed_category directed_category;
+  typedef allow_parallel_edge_tag edge_parallel_category;
+
+  struct traversal_category
+    : vertex_list_graph_tag, edge_list_graph_tag, bidirectional_graph_tag {};
 
   // vertex_type and edge_type are used as their own descriptor,
   // since they are holding pointers to their vertex/edge representations.
@@ -747,8 +1184,16 @@ namespace boost {
   num_edges(const DepGraph &g)
   { return g.num_edges(); }
 
+  ///  The first edge from \p u to \p v, and if it exists.
+  inline std::pair<DepGraphTraits::edge_descriptor, bool>
+  edge(DepGraphTraits::vertex_descriptor u, DepGraphTraits::vertex_descriptor v, const DepGraph &g)
+  {
+    std::pair<DepGraphTraits::out_edge_iterator, DepGraphTraits::out_edge_iterator> r = g.edges_between(u, v);
+    return r.first == r.second ? std::make_pair(g.null_edge(), false) : std::make_pair(*r.first, true);
+  }
+
   // There is no edges(g) function implemented
-  // There is no vertex() / edge() builder implemented.
+  // There is no add_vertex() / add_edge() builder implemented.
 
   // Specialize range iterator type for boost foreach.
   /*
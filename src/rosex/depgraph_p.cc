@@ -4,11 +4,16 @@
 
 #include "rosex/rosex.h"
 #include "rosex/slice_p.h"
+#include "rosex/budget.h"
 #include "rosex/depgraph.h"
 #include "rosex/depgraph_p.h"
 #include "rosex/depgraphopt_p.h"
 #include <DepGraphBuild.h>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
 #include <stdexcept>
 #include <iostream>
@@ -174,10 +179,14 @@ namespace { // anonymous, graph builder implementation
   protected:
     Graph &g;
     GraphAccessWrapTemplate<Node, Edge, Graph> ga;
+    const AnalysisBudget *budget; // checked for each edge
+    bool recomputed; // edges could already exist, such as computed again on demand
 
   public:
-    explicit BuildLoopDepGraphEdges(Graph &graph)
-      : g(graph), ga(&graph) { }
+    explicit BuildLoopDepGraphEdges(Graph &graph, const AnalysisBudget *budget = nullptr)
+      : g(graph), ga(&graph), budget(budget), recomputed(false) { }
+
+    void setRecomputed(bool t) { recomputed = t; }
 
   private:
     Node *CreateNodeImpl(AstNodePtr start, const DomainCond &c) override
@@ -192,15 +201,21 @@ namespace { // anonymous, graph builder implementation
              *n2 = static_cast<Vertex *>(gn2);
       ROSE_ASSERT(n1);
       ROSE_ASSERT(n2);
+      if (budget)
+        budget->check();
 
-      if (info.GetDepType() == DEPTYPE_TRANS)
-        for (GraphCrossEdgeIterator<Graph> crossIter(&g, n1, n2);
-             !crossIter.ReachEnd(); ++crossIter) {
-          DepInfoEdge *e = crossIter.Current();
-          ROSE_ASSERT(e);
-          if (e->GetInfo() == info)
-            return;
-        }
+      // Loop nodes are not in the graph
+      if (n1->isLoop() || n2->isLoop()) {
+        g.edgeStatistics().loops++;
+        return;
+      }
+
+      if (info.GetDepType() == DEPTYPE_TRANS && g.findEdge(n1, n2, info)) {
+        g.edgeStatistics().duplicates++;
+        return;
+      }
+      if (recomputed && g.findEdgeFromOrigAst(n1, n2, info))
+        return;
 
       g.CreateEdgeFromOrigAst(n1, n2, info);
     }
@@ -232,8 +247,8 @@ namespace { // anonymous, graph builder implementation
     SgStatementPtrList::const_iterator current_;
 
   public:
-    BuildLoopDepGraph(SgNode *root, Graph &graph)
-      : Base(graph)
+    BuildLoopDepGraph(SgNode *root, Graph &graph, const AnalysisBudget *budget = nullptr)
+      : Base(graph, budget)
     {
       vertices_ = StatementFilter(root).statements();
       current_ = vertices_.begin();
@@ -254,7 +269,440 @@ namespace { // anonymous, graph builder implementation
 
       SgNode *stmt = *current_++;
       ROSE_ASSERT(stmt);
-      return g.CreateNode(stmt, c);
+      return g.loopNest().isLoop(stmt) ? g.CreateLoopNode(stmt, c) : g.CreateNode(stmt, c);
+    }
+  };
+
+} // anonymous namespace
+
+namespace { // anonymous, regions
+
+  // Statements whose dependences could cross the regions other than through data
+  bool isRegionBarrier(SgNode *stmt)
+  {
+    switch (stmt->variantT()) {
+    case V_SgGotoStatement:
+    case V_SgLabelStatement:
+    case V_SgReturnStmt:
+    case V_SgComputedGotoStatement:
+    case V_SgArithmeticIfStatement:
+    case V_SgStopOrPauseStatement:
+      return true;
+    default:
+      return ::isSgIOStatement(stmt);
+    }
+  }
+
+  // Split the body of a function definition into the top-level statements
+  // having dependence nodes. Return false if they could not be built apart.
+  bool partitionRegions(SgNode *root, SgStatementPtrList &regions)
+  {
+    SgFunctionDefinition *f = ::isSgFunctionDefinition(root);
+    SgBasicBlock *body = f ? f->get_body() : nullptr;
+    if (!body)
+      return false;
+    foreach (SgStatement *stmt, body->get_statements())
+      if (!StatementFilter(stmt).statements().empty())
+        regions.push_back(stmt);
+    if (regions.size() < 2)
+      return false;
+
+    for (size_t i = 0; i + 1 < regions.size(); i++)
+      foreach (SgNode *stmt, NodeQuery::querySubTree(regions[i], V_SgStatement))
+        if (isRegionBarrier(stmt))
+          return false;
+    return true;
+  }
+
+  // Run the jobs from 0 to count - 1 with at most threadCount threads
+  class ParallelFor
+  {
+    typedef ParallelFor Self;
+
+    boost::function<void (size_t)> job_;
+    size_t count_,
+           next_;
+    boost::mutex mutex_;
+
+  public:
+    ParallelFor(size_t count, const boost::function<void (size_t)> &job)
+      : job_(job), count_(count), next_(0) {}
+
+    void run(int threadCount)
+    {
+      if (threadCount > (int)count_)
+        threadCount = count_;
+      if (threadCount <= 1)
+        work();
+      else {
+        boost::thread_group pool;
+        for (int i = 0; i < threadCount; i++)
+          pool.create_thread(boost::bind(&Self::work, this));
+        pool.join_all();
+      }
+    }
+
+  private:
+    bool take(size_t &job)
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      if (next_ >= count_)
+        return false;
+      job = next_++;
+      return true;
+    }
+
+    void work()
+    {
+      size_t job;
+      while (take(job))
+        job_(job);
+    }
+  };
+
+  // Data dependence edges collected without modifying the graph
+  struct CrossEdge
+  {
+    DepGraphPrivate::Vertex *source, *target;
+    DepInfo info;
+
+    CrossEdge(DepGraphPrivate::Vertex *s, DepGraphPrivate::Vertex *t, const DepInfo &i)
+      : source(s), target(t), info(i) {}
+  };
+
+  class CollectLoopDepGraphEdges : public BuildLoopDepGraphEdges
+  {
+    typedef CollectLoopDepGraphEdges  Self;
+    typedef BuildLoopDepGraphEdges    Base;
+
+    std::vector<CrossEdge> &edges_;
+
+  public:
+    CollectLoopDepGraphEdges(Graph &graph, std::vector<CrossEdge> &edges, const AnalysisBudget *budget = nullptr)
+      : Base(graph, budget), edges_(edges) { }
+
+  private:
+    void CreateEdgeImpl(Node *gn1, Node *gn2, DepInfo info) override
+    {
+      Vertex *n1 = static_cast<Vertex *>(gn1),
+             *n2 = static_cast<Vertex *>(gn2);
+      ROSE_ASSERT(n1);
+      ROSE_ASSERT(n2);
+      if (budget)
+        budget->check();
+      edges_.push_back(CrossEdge(n1, n2, info));
+    }
+  };
+
+  // DepTesting options of the graph
+  int testOptions(const DepGraphOption *option)
+  {
+    int ret = 0;
+    if (option) {
+      if (option->memoTests)
+        ret |= DepTesting::Memo;
+      if (option->filterTests || option->verifyTests)
+        ret |= DepTesting::Filter;
+      if (option->verifyTests)
+        ret |= DepTesting::Verify;
+      if (option->exactTests || option->verifyExactTests)
+        ret |= DepTesting::Exact;
+      if (option->verifyExactTests)
+        ret |= DepTesting::VerifyExact;
+    }
+    return ret;
+  }
+
+  /**
+   *  Build the regions into separate graphs concurrently, and merge them
+   *  into the graph in the order of the regions. The data dependences between
+   *  each region and the regions before it are then computed serially and
+   *  added in the same order, so that the graph does not depend on the number
+   *  of threads.
+   *
+   *  The interfaces must be installed by the AnalysisContext::Scope of the
+   *  caller, which the jobs only read. The concurrent jobs each own their
+   *  graph, AstInterface, DepTesting, and DepInfoAnal, and otherwise only
+   *  share the ROSE statics of LoopTransformInterface and the dummy
+   *  AstInterface installed there, which are read but not written while
+   *  traversing. This is assumed rather than documented by ROSE. The cross
+   *  region dependences read the merged graph and compute through the AST of
+   *  several regions at once, so they are not run concurrently. Once the
+   *  budget is exceeded, every thread stops at its next check and the build
+   *  fails.
+   */
+  class RegionDepGraphBuild
+  {
+    typedef RegionDepGraphBuild       Self;
+    typedef DepGraphPrivate::Graph    Graph;
+    typedef DepGraphPrivate::Vertex   Vertex;
+    typedef DepGraphPrivate::Edge     Edge;
+
+    Graph &graph_;
+    const SgStatementPtrList &regions_;
+    int testOptions_;
+    const AnalysisBudget *budget_;
+
+    std::vector<Graph *> subgraphs_;  // by region, deleted once merged
+    std::vector<std::vector<Vertex *> > vertices_; // merged vertices by region
+    std::vector<std::vector<CrossEdge> > crossEdges_; // by target region
+    std::vector<std::string> errors_; // by job
+    std::vector<DepTestStatistics> testStats_; // by job
+
+  public:
+    RegionDepGraphBuild(Graph &graph, const SgStatementPtrList &regions, int testOptions,
+                        const AnalysisBudget *budget = nullptr)
+      : graph_(graph), regions_(regions), testOptions_(testOptions),
+        budget_(budget), subgraphs_(regions.size()), vertices_(regions.size()), crossEdges_(regions.size())
+    {}
+
+    ~RegionDepGraphBuild()
+    { foreach (Graph *g, subgraphs_) delete g; }
+
+    bool run(int threadCount)
+    {
+      errors_.assign(regions_.size(), std::string());
+      testStats_.assign(regions_.size(), DepTestStatistics());
+      ParallelFor(regions_.size(), boost::bind(&Self::buildRegion, this, _1)).run(threadCount);
+      if (!checkErrors() || exceeded())
+        return false;
+
+      for (size_t i = 0; i < regions_.size(); i++)
+        mergeRegion(i);
+      collectTestStatistics();
+
+      errors_.assign(regions_.size(), std::string());
+      for (size_t j = 1; j < regions_.size() && !exceeded(); j++)
+        crossRegion(j);
+      collectTestStatistics();
+      if (!checkErrors() || exceeded())
+        return false;
+
+      foreach (const std::vector<CrossEdge> &l, crossEdges_)
+        foreach (const CrossEdge &e, l)
+          graph_.CreateEdgeFromOrigAst(e.source, e.target, e.info);
+      graph_.clearEdgeIndex();
+      return true;
+    }
+
+  private:
+    bool exceeded() const { return budget_ && budget_->exceeded(); }
+
+    void collectTestStatistics()
+    {
+      foreach (DepTestStatistics &s, testStats_) {
+        graph_.testStatistics() += s;
+        s = DepTestStatistics();
+      }
+    }
+
+    bool checkErrors() const
+    {
+      bool ret = true;
+      foreach (const std::string &e, errors_)
+        if (!e.empty()) {
+          std::cerr << e << std::endl;
+          ret = false;
+        }
+      return ret;
+    }
+
+    void buildRegion(size_t i)
+    {
+      try {
+        SgStatement *root = regions_[i];
+        Graph *g = subgraphs_[i] = new Graph(root, graph_.isPooled());
+        g->setCompactEdges(graph_.compactEdges());
+        AnalysisContext context(root);
+        AstInterface &fa = context.astInterface();
+        BuildLoopDepGraph depImpl(root, *g, budget_);
+        DepTesting testing(testOptions_, budget_);
+        DepInfoAnal anal(fa, testing);
+        BuildAstTreeDepGraph proc(&depImpl, anal);
+        if (!ReadAstTraverse(fa, slice::astnode_cast<AstNodePtr>(root), proc, AstInterface::PreAndPostOrder))
+          errors_[i] = "warning: failed to traverse AST region, abort traversing.";
+        else
+          proc.TranslateCtrlDeps();
+        testStats_[i] = testing.statistics();
+      } catch (AnalysisBudget::Exceeded &) {
+        // reported by run
+      } catch (std::exception &e) {
+        errors_[i] = boost::diagnostic_information(e);
+      }
+    }
+
+    // Copy the vertices, edges, and loop nodes
+    void mergeRegion(size_t i)
+    {
+      Graph *g = subgraphs_[i];
+      ROSE_ASSERT(g);
+      boost::unordered_map<Vertex *, Vertex *> vertices;
+      for (DepGraphPrivate::VertexIterator p = g->GetNodeIterator(); !p.ReachEnd(); ++p)
+        if (Vertex *n = p.Current()) {
+          Vertex *v = graph_.CreateNode(n->statement(), n->loopMap(), n->domain());
+          vertices[n] = v;
+          vertices_[i].push_back(v);
+        }
+
+      for (DepGraphPrivate::VertexIterator p = g->GetNodeIterator(); !p.ReachEnd(); ++p)
+        if (Vertex *n = p.Current())
+          for (DepGraphPrivate::EdgeIterator q = g->GetNodeEdgeIterator(n, GraphAccess::EdgeOut); !q.ReachEnd(); ++q)
+            if (Edge *e = q.Current())
+              graph_.CopyEdge(vertices[n], vertices[g->GetEdgeEndPoint(e, GraphAccess::EdgeIn)], e->GetInfo());
+
+      foreach (const Graph::LoopMap::value_type &p, g->loopNodes())
+        graph_.CreateLoopNode(p.second->statement(), p.second->domain());
+
+      graph_.edgeStatistics().duplicates += g->edgeStatistics().duplicates;
+      graph_.edgeStatistics().loops += g->edgeStatistics().loops;
+      delete g;
+      subgraphs_[i] = nullptr;
+    }
+
+    // Data dependences from the regions before region j to region j
+    void crossRegion(size_t j)
+    {
+      try {
+        AnalysisContext context(regions_[j]);
+        CollectLoopDepGraphEdges impl(graph_, crossEdges_[j], budget_);
+        DepTesting testing(testOptions_, budget_);
+        DepInfoAnal anal(context.astInterface(), testing);
+        AstTreeDepGraphAnal cross(&impl, anal);
+        typedef AstTreeDepGraphAnal::StmtNodeInfo Info;
+        for (size_t i = 0; i < j; i++)
+          foreach (Vertex *u, vertices_[i])
+            foreach (Vertex *v, vertices_[j])
+              cross.ComputeDataDep(
+                Info(u, slice::astnode_cast<AstNodePtr>(u->statement())),
+                Info(v, slice::astnode_cast<AstNodePtr>(v->statement())));
+        testStats_[j] = testing.statistics();
+      } catch (AnalysisBudget::Exceeded &) {
+        // reported by run
+      } catch (std::exception &e) {
+        errors_[j] = boost::diagnostic_information(e);
+      }
+    }
+  };
+
+} // anonymous namespace
+
+namespace { // anonymous, demand
+
+  /**
+   *  Build the graph with the array dependence tests deferred, and then
+   *  compute the data dependences of the deferred statement pairs of each
+   *  demanded statement. A statement is demanded if it contains a seed, or
+   *  is the source of a dependence with expressions into a demanded one.
+   *  The vertices are demanded in a deterministic order, so that the edges
+   *  do not depend on the hash of the pointers.
+   */
+  class DemandDepGraphBuild
+  {
+    typedef DemandDepGraphBuild       Self;
+    typedef DepGraphPrivate::Graph    Graph;
+    typedef DepGraphPrivate::Vertex   Vertex;
+    typedef DepGraphPrivate::Edge     Edge;
+    typedef DepTesting::StatementPair StatementPair;
+
+    Graph &graph_;
+    AstInterface *fa_;
+    int testOptions_;
+    const AnalysisBudget *budget_;
+    const DepGraphOption::predicate_type &seed_;
+
+    std::vector<std::pair<Vertex *, Vertex *> > pairs_; // deferred
+    std::vector<bool> computed_; // by pair
+    boost::unordered_map<Vertex *, std::vector<size_t> > pending_; // pairs by vertex
+    boost::unordered_set<Vertex *> demanded_;
+    std::vector<Vertex *> queue_;
+
+  public:
+    DemandDepGraphBuild(Graph &graph, AstInterface *fa, int testOptions, const AnalysisBudget *budget,
+                        const DepGraphOption::predicate_type &seed)
+      : graph_(graph), fa_(fa), testOptions_(testOptions), budget_(budget), seed_(seed) {}
+
+    bool run(SgNode *root)
+    {
+      graph_.setIndexAllEdges(true); // the edges are looked up when demanded
+      BuildLoopDepGraph depImpl(root, graph_, budget_);
+      {
+        DepTesting deferred(testOptions_ | DepTesting::Defer, budget_);
+        DepInfoAnal anal(*fa_, deferred);
+        BuildAstTreeDepGraph proc(&depImpl, anal);
+        bool ok = ReadAstTraverse(*fa_, slice::astnode_cast<AstNodePtr>(root), proc, AstInterface::PreAndPostOrder);
+        graph_.testStatistics() += deferred.statistics();
+        if (!ok)
+          return false;
+        proc.TranslateCtrlDeps();
+        addPairs(deferred.deferredPairs());
+      }
+
+      foreach (SgNode *e, NodeQuery::querySubTree(root, V_SgExpression))
+        if (seed_(e))
+          demand(enclosingVertex(e));
+
+      depImpl.setRecomputed(true);
+      DepTesting testing(testOptions_, budget_);
+      DepInfoAnal anal(*fa_, testing);
+      AstTreeDepGraphAnal dep(&depImpl, anal);
+      typedef AstTreeDepGraphAnal::StmtNodeInfo Info;
+      while (!queue_.empty()) {
+        Vertex *v = queue_.back();
+        queue_.pop_back();
+        foreach (size_t i, pending_[v])
+          if (!computed_[i]) {
+            computed_[i] = true;
+            graph_.testStatistics().demandedPairs++;
+            Vertex *s = pairs_[i].first,
+                   *t = pairs_[i].second;
+            dep.ComputeDataDep(Info(s, slice::astnode_cast<AstNodePtr>(s->statement())),
+                               Info(t, slice::astnode_cast<AstNodePtr>(t->statement())));
+          }
+        for (DepGraphPrivate::EdgeIterator p = graph_.GetNodeEdgeIterator(v, GraphAccess::EdgeIn); !p.ReachEnd(); ++p)
+          if (Edge *e = p.Current())
+            if (e->GetInfo().SrcRef() && e->GetInfo().SnkRef())
+              demand(graph_.GetEdgeEndPoint(e, GraphAccess::EdgeOut));
+      }
+      graph_.testStatistics() += testing.statistics();
+      return true;
+    }
+
+  private:
+    void addPairs(const std::vector<StatementPair> &l)
+    {
+      foreach (const StatementPair &p, l) {
+        Vertex *s = vertex(p.first),
+               *t = vertex(p.second);
+        if (s && t) { // loop nodes have no edges
+          size_t i = pairs_.size();
+          pairs_.push_back(std::make_pair(s, t));
+          pending_[s].push_back(i);
+          if (t != s)
+            pending_[t].push_back(i);
+        }
+      }
+      computed_.assign(pairs_.size(), false);
+    }
+
+    Vertex *vertex(SgNode *stmt) const
+    {
+      BOOST_AUTO(p, graph_.map().find(stmt));
+      return p == graph_.map().end() ? nullptr : p->second;
+    }
+
+    // The innermost statement of the graph containing the expression
+    Vertex *enclosingVertex(SgNode *e) const
+    {
+      for (SgNode *p = e; p; p = p->get_parent())
+        if (Vertex *v = vertex(p))
+          return v;
+      return nullptr;
+    }
+
+    void demand(Vertex *v)
+    {
+      if (v && demanded_.insert(v).second)
+        queue_.push_back(v);
     }
   };
 
@@ -268,48 +716,43 @@ bool DepGraphPrivate::build(SgNode *root)
     return false;
 
   try {
-    graph.setRoot(root);
-
-    AstInterface *fa = slice::globalAstInterface();
-
-    // Set loop transform interface from \p option
-    //AutoBackup_LoopTransformInterface backup_previous_settings;
-    // 2/14/2014 jichi: FIXME: lacking way to set  interface
-    if (option) {
-      typedef Hacked_LoopTransformInterface la;
-      la::set_astInterfacePtr(fa);
-      la::set_aliasInfo(option->aliasInfo);
-      la::set_sideEffectInfo(option->funcInfo);
-      la::set_arrayInfo(option->arrayInfo);
-      //la::set_stmtSideEffectInterface(option->stmtInfo);
+    AnalysisContext context(root, option);
+    AnalysisContext::Scope scope(context); // install the interfaces of option
+    graph.setRoot(root); // annotate loops before creating nodes
+    AstInterface *fa = &context.astInterface();
+
+    const AnalysisBudget *budget = option ? option->budget : nullptr;
+    if (option && option->demand) {
+      bool ok = DemandDepGraphBuild(graph, fa, testOptions(option), budget, option->demand).run(root);
+      graph.clearEdgeIndex();
+      return ok;
     }
 
+    SgStatementPtrList regions;
+    if (option && option->regionThreads > 1 && partitionRegions(root, regions))
+      return RegionDepGraphBuild(graph, regions, testOptions(option), budget).run(option->regionThreads);
+
     // Process graph
-    BuildLoopDepGraph depImpl(root, graph);
-    DepInfoAnal anal(*fa);
+    BuildLoopDepGraph depImpl(root, graph, budget);
+    DepTesting testing(testOptions(option), budget);
+    DepInfoAnal anal(*fa, testing);
     BuildAstTreeDepGraph proc(&depImpl, anal);
-    if (!ReadAstTraverse(*fa, slice::astnode_cast<AstNodePtr>(root), proc, AstInterface::PreAndPostOrder))
+    bool ok = ReadAstTraverse(*fa, slice::astnode_cast<AstNodePtr>(root), proc, AstInterface::PreAndPostOrder);
+    graph.testStatistics() += testing.statistics();
+    if (!ok)
       return false;
 
     proc.TranslateCtrlDeps();
+    graph.clearEdgeIndex(); // no more edges are created
 
     // 4/21/2014: Delete loop node will break LoopDepGraph.
     // But keep loop node will break dump function.
-    enum { DeleteLoopNode = 1 };
-
-    if (DeleteLoopNode) {
-      boost::unordered_set<Vertex *> loopNodes;
-      for (VertexIterator iter = graph.GetNodeIterator(); !iter.ReachEnd(); ++iter)
-        if (Vertex *n = iter.Current())
-          if (n->isLoop())
-            loopNodes.insert(n);
-
-      foreach (Vertex *n, loopNodes)
-        graph.DeleteNode(n);
-    }
-
+    // Loop nodes are kept in the side table of the graph without edges instead.
     return true;
 
+  } catch (AnalysisBudget::Exceeded &) {
+    graph.setRoot(nullptr);
+    return false;
   } catch (std::exception &e) {
     graph.setRoot(nullptr);
     std::cerr << boost::diagnostic_information(e) << std::endl;
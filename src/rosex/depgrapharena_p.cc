@@ -0,0 +1,99 @@
+// depgrapharena_p.cc
+// 10/18/2026 jichi
+
+#include "rosex/depgrapharena_p.h"
+#include <boost/foreach.hpp>
+#include <new>
+
+#define foreach BOOST_FOREACH
+
+namespace { // anonymous
+
+  enum { Alignment = 2 * sizeof(void *) }; // as malloc on most platforms
+
+  inline size_t align(size_t size)
+  { return (size + Alignment - 1) / Alignment * Alignment; }
+
+} // anonymous namespace
+
+///  Arena of the element, or null if from the heap, and its total size in bytes.
+struct DepGraphArena::Header
+{
+  DepGraphArena *arena;
+  size_t size;
+};
+
+DepGraphArena::~DepGraphArena()
+{
+  foreach (char *b, blocks_)
+    ::operator delete(b);
+}
+
+void *DepGraphArena::allocate(Self *arena, size_t size)
+{
+  const size_t headerSize = align(sizeof(Header));
+  size = headerSize + align(size);
+
+  Header *h;
+  if (arena && arena->pooled_ && size <= BlockSize) {
+    h = arena->take(size);
+    h->arena = arena;
+  } else {
+    h = static_cast<Header *>(::operator new(size));
+    h->arena = nullptr;
+    if (arena) {
+      arena->stats_.heap++;
+      arena->stats_.bytes += size;
+    }
+  }
+  h->size = size;
+  if (arena)
+    arena->stats_.allocations++;
+  return reinterpret_cast<char *>(h) + headerSize;
+}
+
+void DepGraphArena::release(void *p)
+{
+  if (!p)
+    return;
+  Header *h = reinterpret_cast<Header *>(static_cast<char *>(p) - align(sizeof(Header)));
+  if (h->arena)
+    h->arena->recycle(h);
+  else
+    ::operator delete(h);
+}
+
+DepGraphArena::Header *DepGraphArena::take(size_t size)
+{
+  size_t i = size / Alignment;
+  if (i < free_.size() && free_[i]) {
+    Header *h = free_[i];
+    free_[i] = *reinterpret_cast<Header **>(h);
+    stats_.reuses++;
+    return h;
+  }
+
+  if (size_t(end_ - cursor_) < size) { // the rest of the last block is wasted
+    char *b = static_cast<char *>(::operator new(BlockSize));
+    blocks_.push_back(b);
+    cursor_ = b;
+    end_ = b + BlockSize;
+    stats_.heap++;
+    stats_.bytes += BlockSize;
+  }
+  Header *h = reinterpret_cast<Header *>(cursor_);
+  cursor_ += size;
+  return h;
+}
+
+// Link the element into the free list of its size through its first word
+void DepGraphArena::recycle(Header *h)
+{
+  size_t i = h->size / Alignment;
+  if (i >= free_.size())
+    free_.resize(i + 1, nullptr);
+  *reinterpret_cast<Header **>(h) = free_[i];
+  free_[i] = h;
+}
+
+// EOF
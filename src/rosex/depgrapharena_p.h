@@ -0,0 +1,92 @@
+#ifndef _ROSEX_DEPGRAPHARENA_P_H
+#define _ROSEX_DEPGRAPHARENA_P_H
+
+// depgrapharena_p.h
+// 10/18/2026 jichi
+// Internal header for depgraph memory.
+
+#include "xt/c++11.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ *  \internal
+ *  \brief  Per-graph memory of the vertices and edges of DepGraphBuilder.
+ *
+ *  If pooled, elements are carved from blocks of BlockSize bytes, and freed
+ *  elements are recycled by size for later elements of the same graph. The
+ *  blocks are only released at once on destruction, so that the millions of
+ *  edges of a large function neither go through the heap one by one nor
+ *  fragment it for the next function. Otherwise, the arena is not used, and
+ *  the elements allocated from the heap by the graph are only counted for
+ *  comparison.
+ *
+ *  The DepInfo of the edges is never in the arena: ROSE allocates its
+ *  reference count and matrix of DepRel by the global operator new, and
+ *  frees them when the last handle is released, which could be a copy
+ *  outliving the graph such as in the cache of DepTesting. The matrices
+ *  created with the edges are counted as payloads instead, so that the share
+ *  of the allocations left to ROSE is measured as well.
+ *
+ *  Pooled elements are allocated by allocate() and freed by release(), which
+ *  are called by the class-specific operator new and delete of the element
+ *  classes for the arena, as ROSE deletes the elements of the graph by itself.
+ *  Elements from the heap are plain ROSE classes without a header. The arena
+ *  must outlive the elements, and is not synchronized.
+ */
+class DepGraphArena
+{
+  typedef DepGraphArena Self;
+
+  DepGraphArena(const Self &);
+  Self &operator=(const Self &);
+
+public:
+  enum { BlockSize = 64 * 1024 };
+
+  struct Statistics {
+    size_t allocations, ///< elements allocated
+           reuses,      ///< elements allocated from recycled memory
+           heap,        ///< allocations from the heap, which are blocks if pooled
+           bytes,       ///< bytes allocated from the heap
+           payloads,    ///< DepInfo matrices of the edges, allocated by ROSE
+           relations;   ///< DepRel entries in the payloads
+
+    Statistics() : allocations(0), reuses(0), heap(0), bytes(0), payloads(0), relations(0) {}
+  };
+
+  explicit DepGraphArena(bool pooled = false)
+    : pooled_(pooled), cursor_(nullptr), end_(nullptr) {}
+
+  ~DepGraphArena();
+
+  bool isPooled() const { return pooled_; }
+
+  const Statistics &statistics() const { return stats_; }
+
+  ///  Allocate an element of \p size bytes in \p arena, or from the heap if \p arena is null.
+  static void *allocate(Self *arena, size_t size);
+
+  ///  Count an element of \p size bytes allocated from the heap rather than the arena.
+  void count(size_t size) { stats_.allocations++; stats_.heap++; stats_.bytes += size; }
+
+  ///  Count the DepInfo of an edge with \p relations entries, allocated by ROSE rather than the arena.
+  void countPayload(size_t relations) { stats_.payloads++; stats_.relations += relations; }
+
+  ///  Free the element allocated by allocate().
+  static void release(void *p);
+
+private:
+  struct Header; // before each element
+
+  Header *take(size_t size);
+  void recycle(Header *h);
+
+  bool pooled_;
+  char *cursor_, *end_; // free space in the last block
+  std::vector<char *> blocks_;
+  std::vector<Header *> free_; // recycled elements by size / alignment
+  Statistics stats_;
+};
+
+#endif // _ROSEX_DEPGRAPHARENA_P_H
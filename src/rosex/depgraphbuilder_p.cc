@@ -4,6 +4,51 @@
 #include "rosex/rosex.h"
 #include "rosex/slice_p.h"
 #include "rosex/depgraphbuilder_p.h"
+#include <boost/foreach.hpp>
+
+#define foreach BOOST_FOREACH
+
+DepGraphBuilder::~DepGraphBuilder()
+{
+  foreach (const LoopMap::value_type &p, loops_)
+    delete p.second;
+}
+
+// - Allocation -
+
+DepGraphNode *DepGraphBuilder::newNode(SgNode *stmt)
+{
+  if (isPooled())
+    return new (arena()) DepGraphArenaNode(this, &nest_, stmt);
+  arena()->count(sizeof(DepGraphNode));
+  return new DepGraphNode(this, &nest_, stmt);
+}
+
+DepGraphNode *DepGraphBuilder::newNode(SgNode *stmt, const DomainCond &c)
+{
+  if (isPooled())
+    return new (arena()) DepGraphArenaNode(this, &nest_, stmt, c);
+  arena()->count(sizeof(DepGraphNode));
+  return new DepGraphNode(this, &nest_, stmt, c);
+}
+
+DepGraphNode *DepGraphBuilder::newNode(SgNode *stmt, const DepInfo &m, const DomainCond &c)
+{
+  if (isPooled())
+    return new (arena()) DepGraphArenaNode(this, &nest_, stmt, m, c);
+  arena()->count(sizeof(DepGraphNode));
+  return new DepGraphNode(this, &nest_, stmt, m, c);
+}
+
+DepInfoEdge *DepGraphBuilder::newEdge(const DepInfo &info)
+{
+  if (isPooled())
+    return new (arena()) DepGraphArenaEdge(this, info);
+  arena()->count(sizeof(DepInfoEdge));
+  return new DepInfoEdge(this, info);
+}
+
+// - Nodes and edges -
 
 void DepGraphBuilder::AddNode(DepGraphNode *result)
 {
@@ -24,7 +69,7 @@ DepGraphNode *DepGraphBuilder::CreateNode(SgNode *stmt, const DomainCond &c)
   ROSE_ASSERT(stmt);
   DepGraphNode *result = map_[stmt];
   if (!result) {
-    result = new DepGraphNode(this, root_, stmt, c);
+    result = newNode(stmt, c);
     AddNode(result);
   }
   return result;
@@ -35,18 +80,35 @@ DepGraphNode *DepGraphBuilder::CreateNode(SgNode *stmt, const DepInfo &m, const
   ROSE_ASSERT(stmt);
   DepGraphNode *result = map_[stmt];
   if (!result) {
-    result = new DepGraphNode(this, root_, stmt, m, c);
+    result = newNode(stmt, m, c);
     AddNode(result);
   }
   return result;
 }
 
+DepGraphNode *DepGraphBuilder::CreateLoopNode(SgNode *stmt, const DomainCond &c)
+{
+  ROSE_ASSERT(stmt);
+  DepGraphNode *&result = loops_[stmt];
+  if (!result) {
+    result = newNode(stmt, c);
+    ROSE_ASSERT(result->isLoop());
+  }
+  return result;
+}
+
+const DepGraphNode *DepGraphBuilder::loopNode(const SgNode *loop) const
+{
+  LoopMap::const_iterator p = loops_.find(loop);
+  return p == loops_.end() ? nullptr : p->second;
+}
+
 DepGraphNode *DepGraphBuilder::CreateNode(SgNode *stmt)
 {
   ROSE_ASSERT(stmt);
   DepGraphNode *result = map_[stmt];
   if (!result) {
-    result = new DepGraphNode(this, root_, stmt);
+    result = newNode(stmt);
     AddNode(result);
   }
   return result;
@@ -57,11 +119,11 @@ DepGraphNode *DepGraphBuilder::CreateNode(SgNode *stmt, const DepGraphNode *that
   ROSE_ASSERT(stmt);
   ROSE_ASSERT(that);
 
-  ROSE_ASSERT(root_ == that->root());
+  ROSE_ASSERT(root() == that->root());
 
   DepGraphNode *result = map_[stmt];
   if (!result) {
-    result = new DepGraphNode(this, root_, stmt, that->loopMap(), that->domain());
+    result = newNode(stmt, that->loopMap(), that->domain());
     AddNode(result);
   }
   return result;
@@ -75,15 +137,102 @@ DepGraphNode *DepGraphBuilder::CreateNode(SgNode *stmt, const DepGraphNode *that
 //DepGraphBuilder::CreateEdge(DepGraphNode *source, DepGraphNode *target, const DepInfo &info)
 //{ return Base::CreateEdge(source, target, info); }
 
-DepInfoEdge *DepGraphBuilder::CreateEdgeFromOrigAst(DepGraphNode *source, DepGraphNode *target, const DepInfo &info)
+DepInfo DepGraphBuilder::edgeInfoFromOrigAst(DepGraphNode *source, DepGraphNode *target, const DepInfo &info)
 {
-  ROSE_ASSERT(source);
-  ROSE_ASSERT(target);
   DepInfo edge_info = source->isLoop() || source->loopMap().IsID() ? info :
                       ::Reverse(source->loopMap()) * info;
   if (!target->isLoop() && !target->loopMap().IsID())
     edge_info = edge_info * target->loopMap();
-  return CreateEdge(source, target, edge_info);
+  return edge_info;
+}
+
+DepInfoEdge *DepGraphBuilder::CreateEdgeFromOrigAst(DepGraphNode *source, DepGraphNode *target, const DepInfo &info)
+{
+  ROSE_ASSERT(source);
+  ROSE_ASSERT(target);
+  return addEdge(source, target, edgeInfoFromOrigAst(source, target, info));
+}
+
+DepInfoEdge *DepGraphBuilder::CopyEdge(DepGraphNode *source, DepGraphNode *target, const DepInfo &info)
+{
+  ROSE_ASSERT(source);
+  ROSE_ASSERT(target);
+  return addEdge(source, target, info);
+}
+
+DepInfoEdge *DepGraphBuilder::addEdge(DepGraphNode *source, DepGraphNode *target, const DepInfo &info)
+{
+  // Same as DepInfoGraphCreate::CreateEdge except for the allocation
+  DepInfoEdge *ret = newEdge(compactEdges_ && isDataDep(info) ? compactInfo(info) : info);
+  if (size_t relations = ret->GetInfo().rows() * ret->GetInfo().cols())
+    arena()->countPayload(relations);
+  AddEdge(source, target, ret);
+  edgeStats_.created++;
+  // Only the transitive edges are looked up when built at once
+  if (indexAllEdges_ || info.GetDepType() == DEPTYPE_TRANS)
+    edgeIndex_.insert(EdgeIndex::value_type(edgeKey(source, target, ret->GetInfo()), ret));
+  return ret;
+}
+
+// - Compaction -
+
+bool DepGraphBuilder::isDataDep(const DepInfo &info)
+{ return !(info.GetDepType() & (DEPTYPE_CTRL | DEPTYPE_BACKCTRL | DEPTYPE_TRANS)); }
+
+DepInfo DepGraphBuilder::compactInfo(const DepInfo &info)
+{
+  if (info.IsTop() || !info.rows() && !info.cols())
+    return info;
+  return DepInfoGenerator::GetDepInfo(0, 0, info.GetDepType(), info.SrcRef(), info.SnkRef(),
+                                      info.is_precise(), info.CommonLevel());
+}
+
+void DepGraphBuilder::compact()
+{
+  for (NodeIterator p = GetNodeIterator(); !p.ReachEnd(); ++p)
+    if (DepGraphNode *n = p.Current()) {
+      for (EdgeIterator q = GetNodeEdgeIterator(n, GraphAccess::EdgeOut); !q.ReachEnd(); ++q)
+        if (DepInfoEdge *e = q.Current())
+          e->GetInfo() = compactInfo(e->GetInfo());
+      n->compact();
+    }
+  foreach (const LoopMap::value_type &p, loops_)
+    p.second->compact();
+  Map().swap(map_);
+  clearEdgeIndex();
+}
+
+// - Edge index -
+
+DepGraphBuilder::EdgeKey DepGraphBuilder::edgeKey(DepGraphNode *source, DepGraphNode *target, const DepInfo &info)
+{
+  // Only the loop relations are hashed, which must be the same for equal DepInfo
+  EdgeKey ret;
+  ret.source = source;
+  ret.target = target;
+  ret.fingerprint = 0;
+  const int rows = info.rows(),
+            cols = info.cols();
+  boost::hash_combine(ret.fingerprint, rows);
+  boost::hash_combine(ret.fingerprint, cols);
+  for (int i = 0; i < rows; i++)
+    for (int j = 0; j < cols; j++) {
+      const DepRel &r = info.Entry(i, j);
+      boost::hash_combine(ret.fingerprint, int(r.GetDirType()));
+      boost::hash_combine(ret.fingerprint, r.GetMinAlign());
+      boost::hash_combine(ret.fingerprint, r.GetMaxAlign());
+    }
+  return ret;
+}
+
+DepInfoEdge *DepGraphBuilder::findEdge(DepGraphNode *source, DepGraphNode *target, const DepInfo &info) const
+{
+  std::pair<EdgeIndex::const_iterator, EdgeIndex::const_iterator>
+      r = edgeIndex_.equal_range(edgeKey(source, target, info));
+  for (EdgeIndex::const_iterator p = r.first; p != r.second; ++p)
+    if (p->second->GetInfo() == info)
+      return p->second;
+  return nullptr;
 }
 
 // EOF
@@ -6,25 +6,105 @@
 // This header is for internal use only.
 
 #include "rosex/depgraphnode_p.h"
+#include "rosex/deptest_p.h"
+#include "rosex/loopnest_p.h"
 #include <DepGraph.h>
+#include <boost/functional/hash.hpp>
 #include <boost/unordered_map.hpp>
 
 class SgNode;
 
-///  \internal  Represent the dependency graph, used to create the graph.
-class DepGraphBuilder : public DepInfoGraphCreate<DepGraphNode>
+///  \internal  Edge allocated in the arena of the graph, seen by ROSE as DepInfoEdge.
+class DepGraphArenaEdge : public DepInfoEdge
+{
+  typedef DepInfoEdge Base;
+
+public:
+  DepGraphArenaEdge(MultiGraphCreate *c, const DepInfo &info) : Base(c, info) {}
+
+  static void *operator new(size_t size, DepGraphArena *arena) { return DepGraphArena::allocate(arena, size); }
+  static void operator delete(void *p, DepGraphArena *) { DepGraphArena::release(p); }
+  static void operator delete(void *p) { DepGraphArena::release(p); }
+};
+
+/**
+ *  \internal  Represent the dependency graph, used to create the graph.
+ *
+ *  The arena is the first base, so that it is destroyed after ROSE has
+ *  deleted the vertices and edges in the destructor of the graph.
+ */
+class DepGraphBuilder : private DepGraphArena, public DepInfoGraphCreate<DepGraphNode>
 {
   typedef DepGraphBuilder                   Self;
   typedef DepInfoGraphCreate<DepGraphNode>  Base;
   typedef boost::unordered_map<SgNode*, DepGraphNode*>  Map; ///< map from AST to DepNode
 
-  SgNode *root_;
+public:
+  typedef boost::unordered_map<const SgNode*, DepGraphNode*>  LoopMap; ///< map from AST loop to loop node
+
+  struct EdgeStatistics {
+    size_t created,     ///< edges created
+           duplicates,  ///< transitive edges not created as they already exist
+           loops;       ///< edges of loop nodes not created
+
+    EdgeStatistics() : created(0), duplicates(0), loops(0) {}
+  };
+
+private:
+  ///  End points and the fingerprint of the DepInfo of an edge.
+  struct EdgeKey {
+    DepGraphNode *source,
+                 *target;
+    size_t fingerprint;
+
+    bool operator==(const EdgeKey &that) const
+    { return source == that.source && target == that.target && fingerprint == that.fingerprint; }
+
+    friend size_t hash_value(const EdgeKey &k)
+    {
+      size_t ret = k.fingerprint;
+      boost::hash_combine(ret, k.source);
+      boost::hash_combine(ret, k.target);
+      return ret;
+    }
+  };
+  typedef boost::unordered_multimap<EdgeKey, DepInfoEdge *> EdgeIndex;
+
+  DepLoopNest nest_;
   Map map_;
+  LoopMap loops_; // owned, not in the graph
+  EdgeIndex edgeIndex_;
+  EdgeStatistics edgeStats_;
+  DepTestStatistics testStats_;
+  bool compactEdges_;
+  bool indexAllEdges_;
+
+  static EdgeKey edgeKey(DepGraphNode *source, DepGraphNode *target, const DepInfo &info);
+  static DepInfo edgeInfoFromOrigAst(DepGraphNode *source, DepGraphNode *target, const DepInfo &info);
+  DepInfoEdge *addEdge(DepGraphNode *source, DepGraphNode *target, const DepInfo &info);
+
+  ///  If \p info is a data dependence, whose loop relations are not read by ROSE after creating the edge.
+  static bool isDataDep(const DepInfo &info);
+
+  ///  DepInfo without rows or columns, keeping the type, the references, the precision, and the common level.
+  static DepInfo compactInfo(const DepInfo &info);
+
+  DepGraphArena *arena() { return this; }
+
+  ///  Allocate a vertex or an edge in the arena if pooled, or from the heap as ROSE.
+  DepGraphNode *newNode(SgNode *stmt);
+  DepGraphNode *newNode(SgNode *stmt, const DomainCond &c);
+  DepGraphNode *newNode(SgNode *stmt, const DepInfo &m, const DomainCond &c);
+  DepInfoEdge *newEdge(const DepInfo &info);
 
   ///   Graph constructions
 public:
-  explicit DepGraphBuilder(SgNode *root = nullptr)
-    : root_(root) { }
+  ///  \p pooled  Allocate the vertices and edges in blocks rather than one by one
+  explicit DepGraphBuilder(SgNode *root = nullptr, bool pooled = false)
+    : DepGraphArena(pooled), compactEdges_(false), indexAllEdges_(false)
+  { setRoot(root); }
+
+  ~DepGraphBuilder();
 
   /**
    *  \brief  AST root used to compute loop information.
@@ -32,8 +112,13 @@ public:
    *  If it is NULL, the root for the entire AST of the source file rather than
    *  root for DepGraph is used.
    */
-  SgNode *root() const { return root_; }
-  void setRoot(SgNode *root) { root_ = root; }
+  SgNode *root() const { return nest_.root(); }
+
+  ///  Set the root, and annotate the loops of the statements under it.
+  void setRoot(SgNode *root) { nest_.build(root); }
+
+  ///  Loop nesting of the statements under the root.
+  const DepLoopNest &loopNest() const { return nest_; }
 
   ///  Map from pointer to AST statement to the corresponding DepGraphNode.
   const Map &map() const { return map_; }
@@ -53,8 +138,81 @@ public:
   DepGraphNode *CreateNode(SgNode*, const DomainCond&);
   DepGraphNode *CreateNode(SgNode*, const DepInfo&, const DomainCond&);
 
+  /**
+   *  \brief  Create the node of a loop header in the side table rather than the graph.
+   *
+   *  Loop nodes are needed by ROSE while building, but are never part of
+   *  the graph, so that the edges of them are not created either.
+   */
+  DepGraphNode *CreateLoopNode(SgNode*, const DomainCond&);
+
+  ///  Loop node of \p loop in the side table, or null.
+  const DepGraphNode *loopNode(const SgNode *loop) const;
+
+  ///  Loop nodes in the side table.
+  const LoopMap &loopNodes() const { return loops_; }
+
   //DepInfoEdge *CreateEdge(DepGraphNode*, DepGraphNode*, const DepInfo&);
   DepInfoEdge *CreateEdgeFromOrigAst(DepGraphNode*, DepGraphNode*, const DepInfo&);
+
+  ///  Create an edge whose DepInfo is already relative to the loops of the nodes, such as copied from another graph.
+  DepInfoEdge *CopyEdge(DepGraphNode*, DepGraphNode*, const DepInfo&);
+
+  /**
+   *  \brief  Return an edge from \p source to \p target whose DepInfo equals \p info, or null.
+   *
+   *  Edges are indexed by their end points and a fingerprint of the loop
+   *  relations in their DepInfo, so that only the edges with the same key
+   *  are compared by DepInfo::operator==, which is expected constant time.
+   *  Only the transitive edges are indexed unless setIndexAllEdges().
+   */
+  DepInfoEdge *findEdge(DepGraphNode *source, DepGraphNode *target, const DepInfo &info) const;
+
+  ///  Return the edge that CreateEdgeFromOrigAst would create the same, or null.
+  DepInfoEdge *findEdgeFromOrigAst(DepGraphNode *source, DepGraphNode *target, const DepInfo &info) const
+  { return findEdge(source, target, edgeInfoFromOrigAst(source, target, info)); }
+
+  /**
+   *  \brief  Index the edges of all types rather than only the transitive ones.
+   *
+   *  Needed before creating the edges that would be looked up again, such as
+   *  the data dependences computed again on demand.
+   */
+  void setIndexAllEdges(bool t) { indexAllEdges_ = t; }
+  bool indexAllEdges() const { return indexAllEdges_; }
+
+  ///  Free the index of edges, after which findEdge() always fails.
+  void clearEdgeIndex() { EdgeIndex().swap(edgeIndex_); }
+
+  /**
+   *  \brief  Release the loop relations of the edges and the vertices, after which no nodes or edges could be created.
+   *
+   *  The DepInfo of each edge is replaced by one without rows or columns,
+   *  which keeps the type, the references, the precision, and the common
+   *  loop level.
+   */
+  void compact();
+
+  /**
+   *  \brief  Create the data dependences already compacted, as by compact().
+   *
+   *  The loop relations of control and transitive dependences are still read
+   *  by ROSE while building, and are kept until compact(). Edges compared
+   *  after creation, such as computed again on demand, must not be compacted.
+   */
+  void setCompactEdges(bool t) { compactEdges_ = t; }
+  bool compactEdges() const { return compactEdges_; }
+
+  const EdgeStatistics &edgeStatistics() const { return edgeStats_; }
+  EdgeStatistics &edgeStatistics() { return edgeStats_; }
+
+  ///  Allocations of the vertices and edges, including the loop nodes.
+  const DepGraphArena::Statistics &allocationStatistics() const { return DepGraphArena::statistics(); }
+  bool isPooled() const { return DepGraphArena::isPooled(); }
+
+  ///  Array dependence tests of DepTesting when building the graph.
+  const DepTestStatistics &testStatistics() const { return testStats_; }
+  DepTestStatistics &testStatistics() { return testStats_; }
 };
 
 #endif //_ROSEX_DEPGRAPH_P_H
@@ -0,0 +1,300 @@
+// depgraphfile.cc
+// 10/18/2026 jichi
+
+#include "rosex/depgraphfile.h"
+#include "rosex/depgraph.h"
+#include <boost/lexical_cast.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//#define DEBUG "depgraphfile"
+#include "xt/xdebug.h"
+
+namespace { // anonymous
+
+  const char MAGIC[8] = { 'S', 'K', 'D', 'E', 'P', 'G', 'R', '\0' };
+
+  // Strings stored once, with the empty string at offset 0
+  class StringTable
+  {
+    std::string data_;
+    boost::unordered_map<std::string, DepGraphFile::uint32> offsets_;
+
+  public:
+    StringTable() : data_(1, '\0') { offsets_[std::string()] = 0; }
+
+    const std::string &data() const { return data_; }
+
+    DepGraphFile::uint32 insert(const std::string &s)
+    {
+      BOOST_AUTO(p, offsets_.find(s));
+      if (p != offsets_.end())
+        return p->second;
+      DepGraphFile::uint32 ret = data_.size();
+      data_.append(s.c_str(), s.size() + 1);
+      offsets_[s] = ret;
+      return ret;
+    }
+  };
+
+  DepGraphFile::Position positionOf(const SgNode *node, StringTable &strings)
+  {
+    DepGraphFile::Position ret = { 0, 0, 0 };
+    if (const SgLocatedNode *n = ::isSgLocatedNode(node))
+      if (const Sg_File_Info *info = n->get_file_info()) {
+        ret.file = strings.insert(info->get_filenameString());
+        ret.line = info->get_line();
+        ret.column = info->get_col();
+      }
+    return ret;
+  }
+
+  template <typename T>
+  inline void writeArray(std::ostream &out, const std::vector<T> &l)
+  {
+    if (!l.empty())
+      out.write(reinterpret_cast<const char *>(&l[0]), l.size() * sizeof(T));
+  }
+
+} // anonymous namespace
+
+// - Write -
+
+bool DepGraphFile::write(const std::string &path, const DepGraph &g)
+{
+  if (!g.valid())
+    return false;
+  const DepGraph::snapshot_type &s = g.snapshot();
+  StringTable strings;
+
+  std::vector<Vertex> vertices(s.num_vertices());
+  for (size_t v = 0; v < vertices.size(); v++) {
+    DepGraph::vertex_type x = s.vertex(v);
+    SgNode *stmt = x.statement();
+    vertices[v].statement = positionOf(stmt, strings);
+    vertices[v].className = strings.insert(stmt ? stmt->class_name() : std::string());
+    vertices[v].level = x.level();
+  }
+
+  std::vector<Edge> edges(s.num_edges());
+  std::vector<Relation> relations;
+  for (size_t e = 0; e < edges.size(); e++) {
+    const DepGraph::snapshot_type::EdgeRecord &r = s.record(e);
+    const DepInfo &info = s.edge(e).depInfo();
+    Edge &x = edges[e];
+    x.source = r.source;
+    x.target = r.target;
+    x.type = r.type;
+    x.commonLevel = info.CommonLevel();
+    x.sourceExpression = positionOf(r.sourceExpression, strings);
+    x.targetExpression = positionOf(r.targetExpression, strings);
+    x.relations = relations.size();
+    x.rows = info.rows();
+    x.cols = info.cols();
+    for (uint32 i = 0; i < x.rows; i++)
+      for (uint32 j = 0; j < x.cols; j++) {
+        const DepRel &rel = info.Entry(i, j);
+        Relation y;
+        y.direction = rel.GetDirType();
+        y.minAlign = rel.GetMinAlign();
+        y.maxAlign = rel.GetMaxAlign();
+        relations.push_back(y);
+      }
+  }
+
+  std::vector<uint32> outOffsets(1, 0),
+                      inOffsets(1, 0),
+                      inEdges;
+  inEdges.reserve(edges.size());
+  for (size_t v = 0; v < vertices.size(); v++) {
+    outOffsets.push_back(s.out_edge_indices(v).second);
+    BOOST_AUTO(r, s.in_edge_indices(v));
+    inEdges.insert(inEdges.end(), r.first, r.second);
+    inOffsets.push_back(inEdges.size());
+  }
+
+  Header h;
+  std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+  h.version = VERSION;
+  h.vertexCount = vertices.size();
+  h.edgeCount = edges.size();
+  h.relationCount = relations.size();
+  h.stringSize = strings.data().size();
+  h.reserved = 0;
+
+  // Rename is atomic, so that readers never map partial files
+  std::string tmp = path + ".tmp" + boost::lexical_cast<std::string>(::getpid());
+  {
+    std::ofstream out(tmp.c_str(), std::ios::binary|std::ios::trunc);
+    if (!out.is_open())
+      return false;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    writeArray(out, vertices);
+    writeArray(out, edges);
+    writeArray(out, relations);
+    writeArray(out, outOffsets);
+    writeArray(out, inOffsets);
+    writeArray(out, inEdges);
+    out.write(strings.data().c_str(), strings.data().size());
+    if (!out) {
+      out.close();
+      std::remove(tmp.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str())) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  XD("vertices = " << h.vertexCount << ", edges = " << h.edgeCount << ", path = " << path);
+  return true;
+}
+
+// - Read -
+
+void DepGraphFile::clearSections()
+{
+  header_ = nullptr;
+  vertices_ = nullptr;
+  edges_ = nullptr;
+  relations_ = nullptr;
+  outOffsets_ = inOffsets_ = inEdges_ = nullptr;
+  strings_ = nullptr;
+  files_.clear();
+  positions_.clear();
+}
+
+void DepGraphFile::close()
+{
+  if (data_)
+    ::munmap(const_cast<char *>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+  clearSections();
+}
+
+bool DepGraphFile::open(const std::string &path)
+{
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  void *p = MAP_FAILED;
+  if (!::fstat(fd, &st) && st.st_size >= (off_t)sizeof(Header))
+    p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED)
+    return false;
+  data_ = static_cast<const char *>(p);
+  size_ = st.st_size;
+
+  // Locate the sections and check their sizes
+  const Header *h = reinterpret_cast<const Header *>(data_);
+  bool ok = !std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) && h->version == VERSION;
+  size_t offset = sizeof(Header);
+  #define SECTION(_var, _type, _count) \
+    if (ok) { \
+      size_t bytes = size_t(_count) * sizeof(_type); \
+      ok = size_ - offset >= bytes; \
+      _var = reinterpret_cast<const _type *>(data_ + offset); \
+      offset += bytes; \
+    }
+  SECTION(vertices_, Vertex, h->vertexCount)
+  SECTION(edges_, Edge, h->edgeCount)
+  SECTION(relations_, Relation, h->relationCount)
+  SECTION(outOffsets_, uint32, size_t(h->vertexCount) + 1)
+  SECTION(inOffsets_, uint32, size_t(h->vertexCount) + 1)
+  SECTION(inEdges_, uint32, h->edgeCount)
+  SECTION(strings_, char, h->stringSize)
+  #undef SECTION
+  ok = ok && offset == size_ && h->stringSize && !strings_[h->stringSize - 1] &&
+       isConsistent(h);
+  if (!ok) {
+    std::cerr << "depgraphfile::open: warning: malformed file: " << path << std::endl;
+    close();
+    return false;
+  }
+  header_ = h;
+
+  // Index the statements by positions, keeping the first vertex as DepGraph::find
+  for (size_t v = 0; v < h->vertexCount; v++) {
+    const Position &pos = vertices_[v].statement;
+    if (pos.line) {
+      files_.insert(std::make_pair(std::string(string(pos.file)), pos.file));
+      PositionKey k = { pos.file, pos.line, pos.column };
+      positions_.insert(std::make_pair(k, v));
+    }
+  }
+  XD("vertices = " << h->vertexCount << ", edges = " << h->edgeCount << ", path = " << path);
+  return true;
+}
+
+bool DepGraphFile::isConsistent(const Header *h) const
+{
+  const uint32 V = h->vertexCount,
+               E = h->edgeCount;
+  #define CHECK(_cond)  if (!(_cond)) return false;
+  CHECK(!outOffsets_[0] && outOffsets_[V] == E && !inOffsets_[0] && inOffsets_[V] == E)
+  for (uint32 v = 0; v < V; v++) {
+    CHECK(outOffsets_[v] <= outOffsets_[v + 1] && inOffsets_[v] <= inOffsets_[v + 1])
+    CHECK(vertices_[v].statement.file < h->stringSize && vertices_[v].className < h->stringSize)
+  }
+  for (uint32 e = 0; e < E; e++) {
+    const Edge &x = edges_[e];
+    CHECK(x.source < V && x.target < V && inEdges_[e] < E)
+    CHECK(e >= outOffsets_[x.source] && e < outOffsets_[x.source + 1])
+    CHECK(x.sourceExpression.file < h->stringSize && x.targetExpression.file < h->stringSize)
+    CHECK(x.relations <= h->relationCount && (boost::uint64_t)x.rows * x.cols <= h->relationCount - x.relations)
+  }
+  #undef CHECK
+  return true;
+}
+
+// - Queries -
+
+size_t DepGraphFile::num_edges(int mask) const
+{
+  size_t ret = 0;
+  for (size_t e = 0; e < num_edges(); e++)
+    if (edges_[e].type & mask)
+      ret++;
+  return ret;
+}
+
+std::pair<size_t, size_t> DepGraphFile::edges_between(size_t u, size_t v) const
+{
+  // Out-edges of a vertex are sorted by target
+  size_t first = outOffsets_[u],
+         last = outOffsets_[u + 1];
+  while (first < last) {
+    size_t mid = first + (last - first) / 2;
+    if (edges_[mid].target < v)
+      first = mid + 1;
+    else
+      last = mid;
+  }
+  last = first;
+  while (last < outOffsets_[u + 1] && edges_[last].target == v)
+    last++;
+  return std::make_pair(first, last);
+}
+
+size_t DepGraphFile::find(const std::string &file, size_t line, size_t column) const
+{
+  BOOST_AUTO(p, files_.find(file));
+  if (p == files_.end())
+    return npos;
+  PositionKey k = { p->second, uint32(line), uint32(column) };
+  BOOST_AUTO(q, positions_.find(k));
+  return q == positions_.end() ? npos : q->second;
+}
+
+// EOF
@@ -0,0 +1,184 @@
+#ifndef _ROSEX_DEPGRAPHFILE_H
+#define _ROSEX_DEPGRAPHFILE_H
+
+// depgraphfile.h
+// 10/18/2026 jichi
+// Binary file of the dependence graph of a function.
+
+#include "xt/c++11.h"
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+#include <string>
+#include <utility>
+
+class DepGraph;
+
+/**
+ *  \brief  Dependence graph saved by DepGraph::save and mapped without ROSE.
+ *
+ *  The file consists of fixed-size records in the order of the snapshot of
+ *  the DepGraph, followed by a table of null-terminated strings:
+ *  - Header
+ *  - Vertex × vertexCount: statement position, class name, loop level
+ *  - Edge × edgeCount: end points, DepType, common loop level, positions of
+ *    the source and target expressions, and the range of its relations
+ *  - Relation × relationCount: direction and alignments of each loop pair,
+ *    i.e. the rows × cols entries of the DepInfo in row-major order
+ *  - uint32 × (vertexCount + 1): out-edge offsets, edges are numbered by source
+ *  - uint32 × (vertexCount + 1): in-edge offsets
+ *  - uint32 × edgeCount: in-edges grouped by target
+ *  - char × stringSize: file and class names
+ *
+ *  Integers are in the native byte order, and the file is only read by the
+ *  same platform that writes it. open() maps the file read-only, and checks
+ *  the sections and indexes the statement positions in linear time. The
+ *  other queries index into the mapping without copying.
+ *
+ *  Vertices and edges are numbered as DepGraph::snapshot_type, and out-edges
+ *  of a vertex are sorted by target.
+ */
+class DepGraphFile
+{
+  typedef DepGraphFile Self;
+
+public:
+  typedef boost::uint32_t uint32;
+  typedef boost::int32_t int32;
+
+  static const size_t npos = size_t(-1);
+  static const uint32 VERSION = 1;
+
+  // - Records -
+
+  struct Position {
+    uint32 file;    ///< offset of the file name in the strings
+    uint32 line,
+           column;
+  };
+
+  struct Header {
+    char magic[8];  ///< "SKDEPGR\0"
+    uint32 version,
+           vertexCount,
+           edgeCount,
+           relationCount,
+           stringSize,
+           reserved;
+  };
+
+  struct Vertex {
+    Position statement;
+    uint32 className; ///< offset of the sage class name in the strings
+    int32 level;      ///< number of enclosing loops
+  };
+
+  struct Edge {
+    uint32 source,
+           target;
+    int32 type;       ///< DepType
+    int32 commonLevel;
+    Position sourceExpression, ///< line 0 if none
+             targetExpression;
+    uint32 relations, ///< first relation
+           rows,      ///< loops of the source
+           cols;      ///< loops of the target
+  };
+
+  struct Relation {
+    int32 direction;  ///< DepDirType
+    int32 minAlign,
+          maxAlign;
+  };
+
+  typedef std::pair<const uint32 *, const uint32 *> edge_index_range;
+
+  // - Constructions -
+public:
+  DepGraphFile() : data_(nullptr), size_(0) { clearSections(); }
+  ~DepGraphFile() { close(); }
+
+  ///  Write \p g to \p path. Return false if the graph is invalid or the file is not writable.
+  static bool write(const std::string &path, const DepGraph &g);
+
+  ///  Map \p path. Return false if the file is missing or malformed.
+  bool open(const std::string &path);
+  void close();
+
+  bool valid() const { return data_; }
+
+  // - Graph -
+public:
+  size_t num_vertices() const { return header_ ? header_->vertexCount : 0; }
+  size_t num_edges() const { return header_ ? header_->edgeCount : 0; }
+  ///  Number of edges whose types intersect \p mask, in linear time.
+  size_t num_edges(int mask) const;
+
+  const Vertex &vertex(size_t v) const { return vertices_[v]; }
+  const Edge &edge(size_t e) const { return edges_[e]; }
+
+  ///  Relation of the source loop \p i and the target loop \p j of edge \p e.
+  const Relation &relation(size_t e, size_t i, size_t j) const
+  { return relations_[edges_[e].relations + i * edges_[e].cols + j]; }
+
+  ///  Null-terminated string at \p offset of the string table.
+  const char *string(uint32 offset) const { return strings_ + offset; }
+
+  size_t out_degree(size_t v) const { return outOffsets_[v + 1] - outOffsets_[v]; }
+  size_t in_degree(size_t v) const { return inOffsets_[v + 1] - inOffsets_[v]; }
+
+  ///  Out-edges of \p v are numbered in [first, second).
+  std::pair<size_t, size_t> out_edges(size_t v) const
+  { return std::pair<size_t, size_t>(outOffsets_[v], outOffsets_[v + 1]); }
+
+  ///  Numbers of the in-edges of \p v.
+  edge_index_range in_edges(size_t v) const
+  { return edge_index_range(inEdges_ + inOffsets_[v], inEdges_ + inOffsets_[v + 1]); }
+
+  ///  Edges from \p u to \p v are numbered in [first, second), by binary search.
+  std::pair<size_t, size_t> edges_between(size_t u, size_t v) const;
+
+  bool contains(size_t u, size_t v) const
+  { std::pair<size_t, size_t> r = edges_between(u, v); return r.first != r.second; }
+
+  ///  Return the first vertex of the statement at the position, or npos.
+  size_t find(const std::string &file, size_t line, size_t column) const;
+
+private:
+  void clearSections();
+  bool isConsistent(const Header *h) const;
+
+  DepGraphFile(const Self &);
+  Self &operator=(const Self &);
+
+  struct PositionKey {
+    uint32 file, line, column;
+    bool operator==(const PositionKey &that) const
+    { return file == that.file && line == that.line && column == that.column; }
+  };
+  friend size_t hash_value(const PositionKey &k)
+  {
+    size_t ret = 0;
+    boost::hash_combine(ret, k.file);
+    boost::hash_combine(ret, k.line);
+    boost::hash_combine(ret, k.column);
+    return ret;
+  }
+
+  const char *data_;  // mapping
+  size_t size_;
+
+  const Header *header_;
+  const Vertex *vertices_;
+  const Edge *edges_;
+  const Relation *relations_;
+  const uint32 *outOffsets_,
+               *inOffsets_,
+               *inEdges_;
+  const char *strings_;
+
+  boost::unordered_map<std::string, uint32> files_; // file name offsets
+  boost::unordered_map<PositionKey, size_t> positions_;
+};
+
+#endif // _ROSEX_DEPGRAPHFILE_H
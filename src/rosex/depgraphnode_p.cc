@@ -4,35 +4,61 @@
 #include "rosex/rosex.h"
 //#include "rosex/slice_p.h"
 #include "rosex/depgraphnode_p.h"
+#include "rosex/loopnest_p.h"
 
 // - Construction -
 
-DepGraphNode::DepGraphNode(MultiGraphCreate *c, SgNode *root, SgNode *stmt)
-  : Base(c), root_(root), stmt_(stmt)
+DepGraphNode::DepGraphNode(MultiGraphCreate *c, const DepLoopNest *nest, SgNode *stmt)
+  : Base(c), nest_(nest), stmt_(stmt)
 {
   ROSE_ASSERT(stmt_);
+  annotate();
 
   int l = level();
   loopMap_ = DepInfoGenerator::GetIDDepInfo(l, false);
   domain_ = DomainCond(l);
 }
 
-DepGraphNode::DepGraphNode(MultiGraphCreate *c, SgNode *root, SgNode *stmt,
+DepGraphNode::DepGraphNode(MultiGraphCreate *c, const DepLoopNest *nest, SgNode *stmt,
       const DomainCond &domain)
-  : Base(c), root_(root), stmt_(stmt), domain_(domain)
+  : Base(c), nest_(nest), stmt_(stmt), domain_(domain)
 {
   ROSE_ASSERT(stmt_);
+  annotate();
   loopMap_ = DepInfoGenerator::GetIDDepInfo(level(), false);
 }
 
-DepGraphNode::DepGraphNode(MultiGraphCreate *c, SgNode *root, SgNode *stmt,
+DepGraphNode::DepGraphNode(MultiGraphCreate *c, const DepLoopNest *nest, SgNode *stmt,
       const DepInfo &loopMap, const DomainCond &domain)
-  : Base(c), root_(root), stmt_(stmt), loopMap_(loopMap), domain_(domain)
-{ ROSE_ASSERT(stmt_); }
+  : Base(c), nest_(nest), stmt_(stmt), loopMap_(loopMap), domain_(domain)
+{
+  ROSE_ASSERT(stmt_);
+  annotate();
+}
+
+void DepGraphNode::compact()
+{
+  loopMap_ = DepInfo();
+  domain_ = DomainCond(0);
+}
+
+SgNode *DepGraphNode::root() const
+{ return nest_ ? nest_->root() : nullptr; }
 
 std::string DepGraphNode::toString() const
 { return stmt_? stmt_->unparseToString() : std::string(); }
 
+void DepGraphNode::annotate()
+{
+  if (nest_) {
+    level_ = nest_->level(stmt_);
+    loop_ = nest_->isLoop(stmt_);
+  } else {
+    level_ = levelOf(stmt_, nullptr);
+    loop_ = isLoop(stmt_);
+  }
+}
+
 // - Helpers -
 
 bool DepGraphNode::isLoop(const SgNode *input)
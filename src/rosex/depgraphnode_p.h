@@ -6,11 +6,13 @@
 // Internal header for depgraph vertex
 
 #include "rosex/rose_config.h"
+#include "rosex/depgrapharena_p.h"
 #include <DepInfo.h>    // DepInfo in rose
 #include <DomainInfo.h>   // DomainCond in rose
 #include <MultiGraphCreate.h>   // MultiGraphElem in rose
 
 class SgNode;
+class DepLoopNest;
 
 // This class must be consistent with LoopTreeDepGraphNode in LoopTreeDepComp.h
 ///  \internal  Represent node in the dependency graph.
@@ -19,7 +21,10 @@ class DepGraphNode : public MultiGraphElem
   typedef DepGraphNode  Self;
   typedef MultiGraphElem  Base;
 
-  SgNode *root_, *stmt_;  // Each node holds pointers to AST statement and root
+  const DepLoopNest *nest_; // loop nesting of the statements under the AST root
+  SgNode *stmt_;
+  int level_;   // cached loop level
+  bool loop_;   // cached isLoop
 
   DepInfo loopMap_;
   DomainCond domain_;
@@ -31,13 +36,16 @@ public:
   SgNode *statement() const { return stmt_; }
 
   ///  AST root of the dependency graph, which is used to compute loop level.
-  SgNode *root() const { return root_; }
+  SgNode *root() const;
 
-  ///  Loop level of statement, computed from AST and could get changed if AST is modified.
-  int level() const { return levelOf(stmt_, root_); }
+  ///  Loop nesting shared by the nodes of the graph.
+  const DepLoopNest *loopNest() const { return nest_; }
+
+  ///  Loop level of statement, computed from AST when the node is created.
+  int level() const { return level_; }
 
   ///  If this node is treated as a loop during analysis. This property is computed from AST.
-  bool isLoop() const  { return isLoop(stmt_); }
+  bool isLoop() const  { return loop_; }
 
   ///  \reimp  Unparse corresponding AST statement.
   virtual std::string toString() const;
@@ -52,17 +60,24 @@ public:
    *
    *  Conventions:
    *  - Except AST root which could be 0, all parameters of the constructors must be valid.
-   *  - The node instance is immutable after construction that all properties cannot be modified.
+   *  - The node instance is immutable after construction that all properties cannot be modified,
+   *    except that compact() releases the loop map and the domain.
    */
 public:
-  DepGraphNode(MultiGraphCreate*, SgNode *root, SgNode *stmt);
-  DepGraphNode(MultiGraphCreate*, SgNode *root, SgNode *stmt, const DomainCond&);
-  DepGraphNode(MultiGraphCreate*, SgNode *root, SgNode *stmt, const DepInfo&, const DomainCond&);
+  DepGraphNode(MultiGraphCreate*, const DepLoopNest *nest, SgNode *stmt);
+  DepGraphNode(MultiGraphCreate*, const DepLoopNest *nest, SgNode *stmt, const DomainCond&);
+  DepGraphNode(MultiGraphCreate*, const DepLoopNest *nest, SgNode *stmt, const DepInfo&, const DomainCond&);
 
   const DepInfo &loopMap() const  { return loopMap_; }
   const DomainCond &domain() const  { return domain_; }
 
+  ///  Release the loop map and the domain, which are only needed by ROSE to build the graph.
+  void compact();
+
 protected:
+  ///  \internal  Cache the loop properties of the statement.
+  void annotate();
+
   ///  \internal  Return the level of loops for \p node relative to \p root.
   static int levelOf(const SgNode *stmt, const SgNode *parent);
 
@@ -70,4 +85,22 @@ protected:
   static bool isLoop(const SgNode *stmt);
 };
 
+///  \internal  Node allocated in the arena of the graph, which ROSE deletes through MultiGraphElem.
+class DepGraphArenaNode : public DepGraphNode
+{
+  typedef DepGraphNode Base;
+
+public:
+  DepGraphArenaNode(MultiGraphCreate *c, const DepLoopNest *nest, SgNode *stmt)
+    : Base(c, nest, stmt) {}
+  DepGraphArenaNode(MultiGraphCreate *c, const DepLoopNest *nest, SgNode *stmt, const DomainCond &d)
+    : Base(c, nest, stmt, d) {}
+  DepGraphArenaNode(MultiGraphCreate *c, const DepLoopNest *nest, SgNode *stmt, const DepInfo &m, const DomainCond &d)
+    : Base(c, nest, stmt, m, d) {}
+
+  static void *operator new(size_t size, DepGraphArena *arena) { return DepGraphArena::allocate(arena, size); }
+  static void operator delete(void *p, DepGraphArena *) { DepGraphArena::release(p); }
+  static void operator delete(void *p) { DepGraphArena::release(p); }
+};
+
 #endif //_ROSEX_DEPGRAPHNODE_P_H
@@ -3,28 +3,92 @@
 // Internal header for depgraph.
 
 #include "rosex/depgraphopt_p.h"
+#include "rosex/depgraph.h"
 #include "xt/c++11.h"
+#include <boost/thread/shared_mutex.hpp>
 
 namespace static_initializer {
   AssumeNoAlias AssumeNoAlias;
 }
 
-ArrayAbstractionInterface*
-Hacked_LoopTransformInterface::arrayInfo_bak = nullptr;
-AstInterface*
-Hacked_LoopTransformInterface::fa_bak = nullptr;
+namespace { // anonymous
 
-AliasAnalysisInterface*
-Hacked_LoopTransformInterface::ASSUME_NO_ALIAS = &static_initializer::AssumeNoAlias;
+  // Interfaces in the statics of LoopTransformInterface, guarded by slice::globalAnalysisMutex()
+  AnalysisContext::Interfaces installed;
+
+  // Last id of the contexts with interfaces, only increased
+  unsigned long lastInterfacesId = 0;
+
+  // Installed for ROSE, which does not depend on its root for analysis
+  AstInterface *dummyAstInterface()
+  {
+    static AstInterfaceImpl impl(nullptr);
+    static AstInterface ret(&impl);
+    return &ret;
+  }
+
+} // anonymous namespace
 
 static_initializer::LoopTransformInterfaceInit
-Hacked_LoopTransformInterface::init;
+AnalysisContext::init;
 
 static_initializer::
 LoopTransformInterfaceInit::LoopTransformInterfaceInit()
 {
-  Hacked_LoopTransformInterface::
-  set_aliasInfo(&static_initializer::AssumeNoAlias);
+  LoopTransformInterface::set_astInterface(*dummyAstInterface());
+  LoopTransformInterface::set_aliasInfo(&static_initializer::AssumeNoAlias);
+}
+
+AnalysisContext::Interfaces::Interfaces(const DepGraphOption *option)
+  : aliasInfo(nullptr), funcInfo(nullptr), arrayInfo(nullptr), id(0)
+{
+  if (option) {
+    aliasInfo = option->aliasInfo;
+    funcInfo = option->funcInfo;
+    arrayInfo = option->arrayInfo;
+    if (aliasInfo || funcInfo || arrayInfo)
+      id = __sync_add_and_fetch(&lastInterfacesId, 1);
+  }
+}
+
+AnalysisContext::AnalysisContext(SgNode *root, const DepGraphOption *option)
+  : impl_(root), fa_(&impl_), interfaces_(option) {}
+
+void AnalysisContext::install(const Interfaces &interfaces)
+{
+  LoopTransformInterface::set_astInterface(*dummyAstInterface());
+  LoopTransformInterface::set_aliasInfo(interfaces.aliasInfo ? interfaces.aliasInfo : &static_initializer::AssumeNoAlias);
+  LoopTransformInterface::set_sideEffectInfo(interfaces.funcInfo);
+  LoopTransformInterface::set_arrayInfo(interfaces.arrayInfo);
+  installed = interfaces;
 }
 
+const AnalysisContext::Interfaces &AnalysisContext::installedInterfaces()
+{ return installed; }
+
+AnalysisContext::Scope::Scope(const AnalysisContext &context)
+{ lock(context.interfaces()); }
+
+AnalysisContext::Scope::Scope(const Interfaces &interfaces)
+{ lock(interfaces); }
+
+void AnalysisContext::Scope::lock(const Interfaces &interfaces)
+{
+  boost::shared_mutex &m = slice::globalAnalysisMutex();
+  m.lock_shared();
+  if (installed == interfaces)
+    return; // keep the shared lock
+  m.unlock_shared();
+
+  // No graph is being built while the unique lock is held, and the
+  // interfaces stay installed as the lock is downgraded atomically
+  m.lock();
+  if (!(installed == interfaces))
+    install(interfaces);
+  m.unlock_and_lock_shared();
+}
+
+AnalysisContext::Scope::~Scope()
+{ slice::globalAnalysisMutex().unlock_shared(); }
+
 // EOF
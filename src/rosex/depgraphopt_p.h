@@ -10,69 +10,109 @@
 #  pragma GCC diagnostic ignored "-Woverloaded-virtual" // in qingyi's code
 #endif // __clang__
 
+#include "rosex/slice_p.h"
+#include "xt/c++11.h"
 #include <LoopTransformInterface.h>
 
+struct DepGraphOption;
+
 namespace static_initializer {
   struct LoopTransformInterfaceInit
   { LoopTransformInterfaceInit(); };
 
 } // namespace static_initializer
 
-class Hacked_LoopTransformInterface : public LoopTransformInterface
+/**
+ *  \internal
+ *  \brief  ROSE interfaces used to build one dependence graph.
+ *
+ *  The context owns the AstInterface of the graph, and carries the alias,
+ *  side effect, and array interfaces of its DepGraphOption, so that they are
+ *  passed explicitly through the construction rather than set in statics.
+ *  Each context with interfaces other than the defaults is given a distinct
+ *  id in increasing order, which identifies its interfaces in caches instead
+ *  of their addresses, as a freed interface could be reused at the same
+ *  address. All contexts with the defaults share the id 0.
+ *
+ *  The interfaces are not per thread: ROSE still reads them through the
+ *  process-wide statics of LoopTransformInterface, which remain shared by
+ *  the entire process. A Scope installs them while holding the shared side
+ *  of slice::globalAnalysisMutex(), so that contexts with the same
+ *  interfaces, such as all graphs built by skgen, are built concurrently. A
+ *  context with a different id waits until no graph is being built to
+ *  install its own, and then keeps them installed by downgrading its lock
+ *  without retrying, so that alternating contexts do not starve each other.
+ *  The AstInterface installed is a dummy shared by all contexts, as the
+ *  analyses are given the one of the context.
+ *
+ *  Every ROSE call reading the statics needs a Scope, including the queries
+ *  after the build, such as the transitive dependences of LoopDepGraph.
+ */
+class AnalysisContext
 {
-  typedef Hacked_LoopTransformInterface   Self;
-  typedef LoopTransformInterface          Base;
-
-  static ArrayAbstractionInterface* arrayInfo_bak;
-  static AstInterface* fa_bak;
+  typedef AnalysisContext Self;
 
-  static AliasAnalysisInterface *ASSUME_NO_ALIAS;
   static static_initializer::LoopTransformInterfaceInit init;
 
 public:
-  static void set_aliasInfo(AliasAnalysisInterface* alias)
-  { Base::set_aliasInfo(alias? alias : ASSUME_NO_ALIAS); }
+  ///  Interfaces installed into LoopTransformInterface, null for the defaults.
+  struct Interfaces {
+    AliasAnalysisInterface      *aliasInfo; // assume no alias if null
+    FunctionSideEffectInterface *funcInfo;
+    ArrayAbstractionInterface   *arrayInfo;
+    unsigned long id; // 0 for the defaults, otherwise distinct for each context
+
+    Interfaces() : aliasInfo(nullptr), funcInfo(nullptr), arrayInfo(nullptr), id(0) {}
+
+    ///  Interfaces of \p option with a new id, or the defaults if null
+    explicit Interfaces(const DepGraphOption *option);
+
+    bool operator==(const Interfaces &that) const
+    {
+      return id == that.id &&
+             aliasInfo == that.aliasInfo && funcInfo == that.funcInfo && arrayInfo == that.arrayInfo;
+    }
+  };
+
+  /**
+   *  \internal
+   *  \brief  Install the interfaces of a context until destruction.
+   *
+   *  Scopes must not be nested in the threads of a build, which read the
+   *  interfaces installed by the scope of the caller.
+   */
+  class Scope
+  {
+    Scope(const Scope &);
+    Scope &operator=(const Scope &);
 
-  static void set_astInterfacePtr(AstInterface *fa)
-  { fa_bak = fa; if (fa) Base::set_astInterface(*fa); }
+  public:
+    explicit Scope(const AnalysisContext &context);
+    explicit Scope(const Interfaces &interfaces);
+    ~Scope();
 
-  static AstInterface *getAstInterfacePtr() { return fa_bak; }
-  static ArrayAbstractionInterface *getArrayInfo() { return arrayInfo_bak; }
+  private:
+    void lock(const Interfaces &interfaces);
+  };
 
-  static void set_arrayInfo(ArrayAbstractionInterface *arrayInfo)
-  { arrayInfo_bak = arrayInfo; Base::set_arrayInfo(arrayInfo); }
-};
+  ///  \p root  Function or statement to analyze, \p option  interfaces, or null for the defaults
+  explicit AnalysisContext(SgNode *root = nullptr, const DepGraphOption *option = nullptr);
 
-class AutoBackup_LoopTransformInterface
-{
-  typedef Hacked_LoopTransformInterface la;
+  AstInterface &astInterface() { return fa_; }
+  const Interfaces &interfaces() const { return interfaces_; }
 
-  AstInterface                *fa;
-  AliasAnalysisInterface      *aliasInfo;
-  FunctionSideEffectInterface *funcInfo;
-  ArrayAbstractionInterface   *arrayInfo;
-  //SideEffectAnalysisInterface *stmtInfo;
+  ///  Interfaces installed by the Scope held by the caller, which the analyses actually use.
+  static const Interfaces &installedInterfaces();
 
-public:
-  // Auto-backup on construction.
-  AutoBackup_LoopTransformInterface()
-    : fa(la::getAstInterfacePtr())
-    , aliasInfo(la::getAliasInfo())
-    , funcInfo(la::getSideEffectInterface())
-    , arrayInfo(la::getArrayInfo())
-    // CHECKPOINT 2/14/2014: Retore statement sideeffect interface
-    //, stmtInfo(la::getStmtSideEffectInterface())
-  { }
-
-  // Auto-restore on destruction.
-  ~AutoBackup_LoopTransformInterface()
-  {
-    la::set_astInterfacePtr(fa);
-    la::set_aliasInfo(aliasInfo);
-    la::set_sideEffectInfo(funcInfo);
-    la::set_arrayInfo(arrayInfo);
-    //la::set_stmtSideEffectInterface(stmtInfo);
-  }
+private:
+  AnalysisContext(const Self &);
+  Self &operator=(const Self &);
+
+  static void install(const Interfaces &interfaces);
+
+  AstInterfaceImpl impl_;
+  AstInterface fa_;
+  Interfaces interfaces_;
 };
 
 #endif // _ROSEX_DEPGRAPHOPT_P_H
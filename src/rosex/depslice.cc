@@ -0,0 +1,144 @@
+// depslice.cc
+// 10/18/2026 jichi
+
+#include "rosex/depslice.h"
+#include <boost/foreach.hpp>
+
+#define foreach BOOST_FOREACH
+
+//#define DEBUG "depslice"
+#include "xt/xdebug.h"
+
+// - Construction -
+
+void DepSlice::EdgeIndex::build(const std::vector<Edge> &l, size_t Edge::*target, size_t nodeCount)
+{
+  // Counting sort, stable in the order of the edges
+  offsets.assign(nodeCount + 1, 0);
+  foreach (const Edge &e, l)
+    offsets[e.*target + 1]++;
+  for (size_t i = 0; i < nodeCount; i++)
+    offsets[i + 1] += offsets[i];
+
+  edges.resize(l.size());
+  std::vector<size_t> pos(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < l.size(); i++)
+    edges[pos[l[i].*target]++] = i;
+}
+
+void DepSlice::addEdge(const SgNode *sourceExpression, const SgNode *sourceStatement,
+                       const SgNode *targetExpression, const SgNode *targetStatement)
+{
+  Edge edge;
+  edge.sourceExpression = index_->insert(sourceExpression);
+  edge.sourceStatement = index_->insert(sourceStatement);
+  edge.targetExpression = index_->insert(targetExpression);
+  edge.targetStatement = index_->insert(targetStatement);
+  edges_.push_back(edge);
+}
+
+void DepSlice::buildIndex()
+{
+  byTargetExpression_.build(edges_, &Edge::targetExpression, index_->size());
+  byTargetStatement_.build(edges_, &Edge::targetStatement, index_->size());
+  XD("edges = " << edges_.size() << ", nodes = " << index_->size());
+}
+
+DepSlice::DepSlice(const DepGraph &g, NodeIndex *index)
+  : index_(index)
+{
+  ROSE_ASSERT(index_);
+  if (g.valid()) {
+    const DepGraph::snapshot_type &s = g.snapshot();
+    for (size_t i = 0; i < s.num_edges(); i++) {
+      const DepGraph::snapshot_type::EdgeRecord &r = s.record(i);
+      if (r.sourceExpression && r.targetExpression)
+        addEdge(r.sourceExpression, s.vertex(r.source).statement(),
+                r.targetExpression, s.vertex(r.target).statement());
+    }
+  }
+  buildIndex();
+}
+
+DepSlice::DepSlice(const ApproxDepGraph &g, NodeIndex *index)
+  : index_(index)
+{
+  ROSE_ASSERT(index_);
+  edges_.reserve(g.num_edges());
+  foreach (const ApproxDepGraph::Edge &e, g.edges())
+    addEdge(e.sourceExpression, e.sourceStatement, e.targetExpression, e.targetStatement);
+  buildIndex();
+}
+
+// - Slicing -
+
+void DepSlice::slice(NodeBitSet &refs, NodeBitSet &stmts, const predicate_type &seed) const
+{
+  stats_ = Statistics();
+  refs.resize();
+  stmts.resize();
+
+  const size_t nodeCount = byTargetExpression_.offsets.size() - 1; // nodes when indexed
+  const NodeBitSet initialRefs = refs,
+                   initialStmts = stmts;
+
+  std::vector<bool> visited(edges_.size());
+  std::vector<size_t> refQueue, stmtQueue;
+
+  // Mark the sources of the edge as critical, and queue the new ones
+  #define VISIT(_i) \
+    if (!visited[_i]) { \
+      visited[_i] = true; \
+      const Edge &e = edges_[_i]; \
+      if (refs.insert(e.sourceExpression)) \
+        refQueue.push_back(e.sourceExpression); \
+      if (stmts.insert(e.sourceStatement)) \
+        stmtQueue.push_back(e.sourceStatement); \
+    }
+  #define EDGES(_index, _id) \
+    for (size_t i = (_index).offsets[_id], end = (_index).offsets[(_id) + 1]; i != end; i++)
+
+  // Seeds: edges whose targets are initially critical or satisfy the predicate
+  for (size_t id = 0; id < nodeCount; id++) {
+    if (byTargetExpression_.offsets[id] != byTargetExpression_.offsets[id + 1] &&
+        (initialRefs.test(id) || (seed && seed(index_->node(id)))))
+      EDGES(byTargetExpression_, id)
+        if (!visited[byTargetExpression_.edges[i]]) {
+          stats_.seeds++;
+          VISIT(byTargetExpression_.edges[i])
+        }
+    if (initialStmts.test(id))
+      EDGES(byTargetStatement_, id)
+        if (!visited[byTargetStatement_.edges[i]]) {
+          stats_.seeds++;
+          VISIT(byTargetStatement_.edges[i])
+        }
+  }
+
+  // Propagate through edges targeting new critical nodes
+  while (!refQueue.empty() || !stmtQueue.empty()) {
+    const EdgeIndex *index;
+    size_t id;
+    if (!refQueue.empty()) {
+      index = &byTargetExpression_;
+      id = refQueue.back();
+      refQueue.pop_back();
+    } else {
+      index = &byTargetStatement_;
+      id = stmtQueue.back();
+      stmtQueue.pop_back();
+    }
+    if (id < nodeCount)
+      EDGES(*index, id)
+        if (!visited[index->edges[i]]) {
+          stats_.visits++;
+          VISIT(index->edges[i])
+        }
+  }
+  #undef EDGES
+  #undef VISIT
+  XD("refs = " << refs.count() << ", stmts = " << stmts.count()
+     << ", seeds = " << stats_.seeds << ", visits = " << stats_.visits);
+}
+
+// EOF
@@ -0,0 +1,94 @@
+#ifndef _ROSEX_DEPSLICE_H
+#define _ROSEX_DEPSLICE_H
+
+// depslice.h
+// 10/18/2026 jichi
+// Backward slicing over the dependence graph.
+
+#include "rosex/approxdepgraph.h"
+#include "rosex/depgraph.h"
+#include "rosex/nodeset.h"
+#include <boost/function.hpp>
+#include <vector>
+
+/**
+ *  \brief  Propagate critical references backward along dependence edges.
+ *
+ *  An edge with both source and target expressions is critical if its target
+ *  expression is critical, its target statement is critical, or the target
+ *  expression satisfies the seed predicate. The source expression and the
+ *  source statement of a critical edge become critical as well.
+ *
+ *  The expressions and statements of the edges are numbered by a NodeIndex,
+ *  and the edges are indexed by the numbers of their targets on construction.
+ *  slice() then computes the least closure over bitsets with a worklist,
+ *  visiting each edge at most once, and evaluating the predicate once per
+ *  distinct target expression.
+ */
+class DepSlice
+{
+  typedef DepSlice Self;
+
+public:
+  typedef boost::function<bool (const SgNode *)> predicate_type;
+
+  ///  Counters of the last slice().
+  struct Statistics {
+    size_t seeds,   ///< edges made critical by the initial sets or the predicate
+           visits;  ///< edges visited through the worklist
+
+    Statistics() : seeds(0), visits(0) {}
+  };
+
+  /**
+   *  \brief  Index the edges of \p g.
+   *  \param  index  number the nodes of the edges, must outlive the slicer
+   */
+  DepSlice(const DepGraph &g, NodeIndex *index);
+
+  ///  Index the edges of the approximate graph \p g instead.
+  DepSlice(const ApproxDepGraph &g, NodeIndex *index);
+
+  ///  Number of indexed edges.
+  size_t size() const { return edges_.size(); }
+
+  const NodeIndex &index() const { return *index_; }
+
+  /**
+   *  \brief  Extend \p refs and \p stmts to the closure.
+   *  \param  refs  critical expressions of index(), could be non-empty initially
+   *  \param  stmts  critical statements of index(), could be non-empty initially
+   *  \param  seed  predicate on target expressions
+   */
+  void slice(NodeBitSet &refs, NodeBitSet &stmts, const predicate_type &seed) const;
+
+  const Statistics &statistics() const { return stats_; }
+
+private:
+  struct Edge { // numbers in index_
+    size_t sourceExpression,
+           sourceStatement,
+           targetExpression,
+           targetStatement;
+  };
+
+  ///  Edges grouped by the number of a target, in compressed rows.
+  struct EdgeIndex {
+    std::vector<size_t> offsets, // edges of node i are in [offsets[i], offsets[i+1])
+                        edges;   // indices of edges_
+
+    void build(const std::vector<Edge> &l, size_t Edge::*target, size_t nodeCount);
+  };
+
+  void addEdge(const SgNode *sourceExpression, const SgNode *sourceStatement,
+               const SgNode *targetExpression, const SgNode *targetStatement);
+  void buildIndex();
+
+  NodeIndex *index_;
+  std::vector<Edge> edges_;  // in the order of the snapshot
+  EdgeIndex byTargetExpression_,
+            byTargetStatement_;
+  mutable Statistics stats_;
+};
+
+#endif // _ROSEX_DEPSLICE_H
@@ -0,0 +1,542 @@
+// deptest_p.cc
+// 10/18/2026 jichi
+
+#include "rosex/rosex.h"
+#include "rosex/slice_p.h"
+#include "rosex/budget.h"
+#include "rosex/deptest_p.h"
+#include "rosex/depgraphopt_p.h"
+#include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/typeof/typeof.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/math/common_factor_rt.hpp>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#define foreach BOOST_FOREACH
+
+//#define DEBUG "deptest_p"
+#include "xt/xdebug.h"
+
+enum { MaxCacheSize = 1 << 16 }; // number of tests, cleared when full
+
+namespace { // anonymous
+
+  // Canonical text of expressions and loops, where variables are numbered by
+  // their first occurrences. It becomes invalid for unsupported nodes.
+  class CanonicalForm
+  {
+    typedef CanonicalForm Self;
+
+    std::ostringstream out_;
+    boost::unordered_map<const SgNode *, int> vars_;
+    bool valid_;
+
+  public:
+    CanonicalForm() : valid_(true) {}
+
+    bool valid() const { return valid_; }
+    std::string str() const { return out_.str(); }
+
+    template <typename T>
+    Self &operator<<(const T &value) { out_ << value; return *this; }
+
+    void variable(const SgNode *var)
+    {
+      if (!var) {
+        valid_ = false;
+        return;
+      }
+      int id = vars_.insert(std::make_pair(var, int(vars_.size()))).first->second;
+      out_ << 'v' << id;
+    }
+
+    void expression(SgNode *node);
+
+    // Enclosing loops of stmt from the outermost, which must be canonical
+    void loops(SgNode *stmt);
+  };
+
+  void CanonicalForm::expression(SgNode *node)
+  {
+    if (!valid_)
+      return;
+    if (!node) {
+      out_ << '_';
+      return;
+    }
+    switch (node->variantT()) {
+    case V_SgVarRefExp:
+      {
+        SgVariableSymbol *s = ::isSgVarRefExp(node)->get_symbol();
+        variable(s ? s->get_declaration() : nullptr);
+      } return;
+    case V_SgInitializedName:
+      variable(node);
+      break;
+    #define CASE(_type) \
+      case V_##_type: out_ << 'c' << ::is##_type(node)->get_value(); return;
+    CASE(SgIntVal)
+    CASE(SgLongIntVal)
+    CASE(SgLongLongIntVal)
+    CASE(SgShortVal)
+    CASE(SgUnsignedIntVal)
+    CASE(SgUnsignedLongVal)
+    CASE(SgUnsignedLongLongIntVal)
+    CASE(SgUnsignedShortVal)
+    #undef CASE
+    case V_SgFunctionCallExp:
+      valid_ = false;
+      return;
+    default:
+      if (::isSgValueExp(node)) {
+        valid_ = false;
+        return;
+      }
+    }
+    out_ << int(node->variantT()) << '(';
+    foreach (SgNode *child, node->get_traversalSuccessorContainer()) {
+      expression(child);
+      out_ << ',';
+    }
+    out_ << ')';
+  }
+
+  void CanonicalForm::loops(SgNode *stmt)
+  {
+    std::vector<SgNode *> l;
+    if (!rosex::getEnclosingLoops(stmt, l)) {
+      valid_ = false;
+      return;
+    }
+    foreach (SgNode *loop, l) {
+      SgInitializedName *ivar = nullptr;
+      SgExpression *lb = nullptr,
+                   *ub = nullptr,
+                   *step = nullptr;
+      bool incremental = false,
+           inclusive = false;
+      if (!rosex::isCanonicalLoop(loop, &ivar, &lb, &ub, &step, nullptr, &incremental, &inclusive)) {
+        valid_ = false;
+        return;
+      }
+      out_ << 'L';
+      variable(ivar);
+      out_ << ':';
+      expression(lb);
+      out_ << ':';
+      expression(ub);
+      out_ << ':';
+      expression(step);
+      out_ << ':' << incremental << inclusive << ';';
+    }
+  }
+
+  // Return 0 for the same statement, 1 if s1 is before s2, 2 if after, or -1 if unknown
+  int statementOrder(const SgNode *s1, const SgNode *s2)
+  {
+    if (s1 == s2)
+      return 0;
+    const SgLocatedNode *n1 = ::isSgLocatedNode(s1),
+                        *n2 = ::isSgLocatedNode(s2);
+    if (!n1 || !n2)
+      return -1;
+    const Sg_File_Info *f1 = n1->get_file_info(),
+                       *f2 = n2->get_file_info();
+    if (!f1 || !f2 || !f1->get_line() || !f2->get_line() ||
+        (f1->get_line() == f2->get_line() && f1->get_col() == f2->get_col()))
+      return -1;
+    return std::make_pair(f1->get_line(), f1->get_col()) < std::make_pair(f2->get_line(), f2->get_col()) ? 1 : 2;
+  }
+
+  // Return the key of the test, or an empty string if not cacheable.
+  // The results depend on the alias, side effect, and array interfaces installed.
+  std::string testKey(const DepInfoAnal::StmtRefDep &ref, DepType deptype)
+  {
+    SgNode *s1 = slice::astnode_cast<SgNode *>(ref.r1.stmt),
+           *s2 = slice::astnode_cast<SgNode *>(ref.r2.stmt),
+           *r1 = slice::astnode_cast<SgNode *>(ref.r1.ref),
+           *r2 = slice::astnode_cast<SgNode *>(ref.r2.ref);
+    int order = statementOrder(s1, s2);
+    if (order < 0)
+      return std::string();
+
+    const AnalysisContext::Interfaces &i = AnalysisContext::installedInterfaces();
+    CanonicalForm f;
+    f << i.id << ';'; // not the addresses, which could be reused once freed
+    f << int(deptype) << ';' << ref.commLevel << ';' << order << (r1 == r2) << ';';
+    f.loops(s1);
+    f << '|';
+    f.loops(s2);
+    f << '|';
+    f.expression(r1);
+    f << '|';
+    f.expression(r2);
+    return f.valid() ? f.str() : std::string();
+  }
+
+  // Copy of the cached result with the references under test
+  DepInfo rebind(const DepInfo &d, const DepInfoAnal::StmtRefDep &ref)
+  {
+    if (d.IsTop())
+      return d;
+    DepInfo ret = DepInfoGenerator::GetDepInfo(d.rows(), d.cols(), d.GetDepType(),
+                                               ref.r1.ref, ref.r2.ref, d.is_precise(), d.CommonLevel());
+    for (int i = 0; i < d.rows(); i++)
+      for (int j = 0; j < d.cols(); j++)
+        ret.Entry(i, j) = d.Entry(i, j);
+    return ret;
+  }
+
+  class DepTestCache
+  {
+    boost::mutex mutex_;
+    boost::unordered_map<std::string, DepInfo> tests_;
+
+  public:
+    bool find(const std::string &key, DepInfo &out)
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      BOOST_AUTO(p, tests_.find(key));
+      if (p == tests_.end())
+        return false;
+      out = p->second;
+      return true;
+    }
+
+    void insert(const std::string &key, const DepInfo &d)
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      if (tests_.size() >= MaxCacheSize)
+        tests_.clear();
+      tests_.insert(std::make_pair(key, d));
+    }
+
+    size_t size()
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      return tests_.size();
+    }
+  };
+
+  DepTestCache &globalCache()
+  {
+    static DepTestCache ret;
+    return ret;
+  }
+
+} // anonymous namespace
+
+namespace { // anonymous, filter
+
+  enum { MaxCoefficient = 1 << 30 }; // give up on larger values to avoid overflow
+
+  // Enclosing loop of a reference, with the constant range of its variable if known
+  struct LoopRange
+  {
+    const SgInitializedName *var;
+    bool bounded;
+    long lower, upper;
+  };
+  typedef std::vector<LoopRange> LoopRangeList;
+
+  bool constantValue(SgExpression *e, long &ret)
+  {
+    if (!e || !::isSgValueExp(e) || !rosex::isIntegerType(e->get_type()))
+      return false;
+    bool ok;
+    ret = rosex::evalLong(e, &ok);
+    return ok && ret >= -MaxCoefficient && ret <= MaxCoefficient;
+  }
+
+  bool loopRanges(SgNode *stmt, LoopRangeList &ret)
+  {
+    std::vector<SgNode *> l;
+    if (!rosex::getEnclosingLoops(stmt, l))
+      return false;
+    foreach (SgNode *loop, l) {
+      SgInitializedName *ivar = nullptr;
+      SgExpression *lb = nullptr,
+                   *ub = nullptr;
+      bool incremental = false,
+           inclusive = false;
+      if (!rosex::isCanonicalLoop(loop, &ivar, &lb, &ub, nullptr, nullptr, &incremental, &inclusive))
+        return false;
+      LoopRange r = { ivar, false, 0, 0 };
+      long first, last;
+      if (constantValue(lb, first) && constantValue(ub, last)) {
+        if (!inclusive)
+          last += incremental ? -1 : 1;
+        // Empty loops are left unbounded
+        if (incremental ? first <= last : last <= first) {
+          r.bounded = true;
+          r.lower = std::min(first, last);
+          r.upper = std::max(first, last);
+        }
+      }
+      ret.push_back(r);
+    }
+    return true;
+  }
+
+  // Affine function of the enclosing loop variables
+  struct Affine
+  {
+    long constant;
+    std::vector<long> coefficients; // by loop
+
+    bool isConstant() const
+    { return std::count(coefficients.begin(), coefficients.end(), 0) == (long)coefficients.size(); }
+
+    bool scale(long k)
+    {
+      if (k < -MaxCoefficient || k > MaxCoefficient)
+        return false;
+      constant *= k;
+      foreach (long &c, coefficients)
+        c *= k;
+      return inRange();
+    }
+
+    bool add(const Affine &that, long sign)
+    {
+      constant += sign * that.constant;
+      for (size_t i = 0; i < coefficients.size(); i++)
+        coefficients[i] += sign * that.coefficients[i];
+      return inRange();
+    }
+
+    bool inRange() const
+    {
+      if (constant < -MaxCoefficient || constant > MaxCoefficient)
+        return false;
+      foreach (long c, coefficients)
+        if (c < -MaxCoefficient || c > MaxCoefficient)
+          return false;
+      return true;
+    }
+  };
+
+  bool linearize(SgExpression *e, const LoopRangeList &loops, Affine &ret)
+  {
+    ret.constant = 0;
+    ret.coefficients.assign(loops.size(), 0);
+    if (!e)
+      return false;
+    switch (e->variantT()) {
+    case V_SgVarRefExp:
+      {
+        SgVariableSymbol *s = ::isSgVarRefExp(e)->get_symbol();
+        const SgInitializedName *var = s ? s->get_declaration() : nullptr;
+        // The innermost loop of the variable
+        for (size_t i = loops.size(); i; i--)
+          if (var && loops[i - 1].var == var) {
+            ret.coefficients[i - 1] = 1;
+            return true;
+          }
+      } return false;
+    case V_SgCastExp:
+      return rosex::isIntegerType(e->get_type()) &&
+             linearize(::isSgCastExp(e)->get_operand(), loops, ret);
+    case V_SgUnaryAddOp:
+      return linearize(::isSgUnaryOp(e)->get_operand(), loops, ret);
+    case V_SgMinusOp:
+      return linearize(::isSgUnaryOp(e)->get_operand(), loops, ret) && ret.scale(-1);
+    case V_SgAddOp:
+    case V_SgSubtractOp:
+    case V_SgMultiplyOp:
+      {
+        SgBinaryOp *op = ::isSgBinaryOp(e);
+        Affine rhs;
+        if (!linearize(op->get_lhs_operand(), loops, ret) ||
+            !linearize(op->get_rhs_operand(), loops, rhs))
+          return false;
+        switch (e->variantT()) {
+        case V_SgAddOp: return ret.add(rhs, 1);
+        case V_SgSubtractOp: return ret.add(rhs, -1);
+        default:
+          if (rhs.isConstant())
+            return ret.scale(rhs.constant);
+          if (ret.isConstant()) {
+            long k = ret.constant;
+            ret = rhs;
+            return ret.scale(k);
+          }
+          return false;
+        }
+      }
+    default:
+      return constantValue(e, ret.constant);
+    }
+  }
+
+  // Add the term c * x with x in loop to the GCD and the bounds of a subscript difference
+  void addTerm(long c, const LoopRange &loop, long &gcd, long &lower, long &upper, bool &bounded)
+  {
+    if (!c)
+      return;
+    gcd = boost::math::gcd(gcd, c < 0 ? -c : c);
+    if (!loop.bounded)
+      bounded = false;
+    else {
+      lower += c * (c > 0 ? loop.lower : loop.upper);
+      upper += c * (c > 0 ? loop.upper : loop.lower);
+    }
+  }
+
+  // GCD and Banerjee tests of f(x) = g(y), where f and g are over different loop instances
+  bool independentSubscript(const Affine &f, const LoopRangeList &l1,
+                            const Affine &g, const LoopRangeList &l2)
+  {
+    long diff = g.constant - f.constant,
+         gcd = 0,
+         lower = 0,
+         upper = 0;
+    bool bounded = true;
+    for (size_t i = 0; i < l1.size(); i++)
+      addTerm(f.coefficients[i], l1[i], gcd, lower, upper, bounded);
+    for (size_t i = 0; i < l2.size(); i++)
+      addTerm(-g.coefficients[i], l2[i], gcd, lower, upper, bounded);
+    if (!gcd)
+      return diff != 0;
+    if (diff % gcd)
+      return true;
+    return bounded && (diff < lower || diff > upper);
+  }
+
+  bool isFilteredIndependent(const DepInfoAnal::StmtRefDep &ref)
+  {
+    SgNode *s1 = slice::astnode_cast<SgNode *>(ref.r1.stmt),
+           *s2 = slice::astnode_cast<SgNode *>(ref.r2.stmt);
+    std::vector<SgExpression *> sub1, sub2;
+    const SgInitializedName *a1 = rosex::getArrayAccess(slice::astnode_cast<SgNode *>(ref.r1.ref), sub1),
+                            *a2 = rosex::getArrayAccess(slice::astnode_cast<SgNode *>(ref.r2.ref), sub2);
+    bool fortran = SageInterface::is_Fortran_language();
+    if (!a1 || !a2 || !rosex::isDeclaredArray(a1, fortran) || !rosex::isDeclaredArray(a2, fortran))
+      return false;
+
+    // Distinct arrays, except Fortran storage association by EQUIVALENCE or COMMON
+    if (a1 != a2)
+      return !fortran && a1->get_name() != a2->get_name();
+
+    if (sub1.empty() || sub1.size() != sub2.size())
+      return false;
+    LoopRangeList l1, l2;
+    if (!loopRanges(s1, l1) || !loopRanges(s2, l2))
+      return false;
+    for (size_t d = 0; d < sub1.size(); d++) {
+      Affine f, g;
+      if (linearize(sub1[d], l1, f) && linearize(sub2[d], l2, g) &&
+          independentSubscript(f, l1, g, l2))
+        return true;
+    }
+    return false;
+  }
+
+  std::string statementPosition(const AstNodePtr &stmt)
+  {
+    std::ostringstream out;
+    if (const SgLocatedNode *n = ::isSgLocatedNode(slice::astnode_cast<SgNode *>(stmt)))
+      if (const Sg_File_Info *info = n->get_file_info())
+        out << info->get_filenameString() << ":" << info->get_line() << ":" << info->get_col();
+    return out.str();
+  }
+
+  // Return if each loop relation of the exact dependence is within the one of ROSE
+  bool refines(const DepInfo &exact, const DepInfo &rose)
+  {
+    if (rose.IsTop()) // proven independent by ROSE
+      return false;
+    if (exact.rows() != rose.rows() || exact.cols() != rose.cols())
+      return false;
+    for (int i = 0; i < exact.rows(); i++)
+      for (int j = 0; j < exact.cols(); j++) {
+        DepRel r = exact.Entry(i, j);
+        r &= rose.Entry(i, j);
+        if (!(r == exact.Entry(i, j)))
+          return false;
+      }
+    return true;
+  }
+
+} // anonymous namespace
+
+bool DepTesting::independent(const DepInfoAnal::StmtRefDep &ref)
+{ return isFilteredIndependent(ref); }
+
+DepInfo DepTesting::ComputeArrayDep(DepInfoAnal &anal, const DepInfoAnal::StmtRefDep &ref, DepType deptype)
+{
+  if (budget_)
+    budget_->check();
+  stats_.tests++;
+  if ((options_ & Filter) && independent(ref)) {
+    stats_.filtered++;
+    if (options_ & Verify) {
+      DepInfo d = adhoc_.ComputeArrayDep(anal, ref, deptype);
+      if (!d.IsTop()) {
+        stats_.mismatches++;
+        std::cerr << "deptest::ComputeArrayDep: warning: filtered test differs from ROSE: "
+                  << statementPosition(ref.r1.stmt) << " -> " << statementPosition(ref.r2.stmt) << std::endl;
+        return d;
+      }
+    }
+    return DepInfo();
+  }
+  if (options_ & Defer) {
+    stats_.deferred++;
+    StatementPair p(slice::astnode_cast<SgNode *>(ref.r1.stmt), slice::astnode_cast<SgNode *>(ref.r2.stmt));
+    if (deferredSet_.insert(p).second)
+      deferred_.push_back(p);
+    return DepInfo();
+  }
+  if (options_ & Exact) {
+    DepInfo d;
+    switch (exact_.test(ref, deptype, d)) {
+    case DepExactTest::Independent:
+      stats_.exact++;
+      return DepInfo();
+    case DepExactTest::Dependent:
+      stats_.exact++;
+      if (options_ & VerifyExact) {
+        DepInfo r = adhoc_.ComputeArrayDep(anal, ref, deptype);
+        if (!refines(d, r)) {
+          stats_.exactMismatches++;
+          std::cerr << "deptest::ComputeArrayDep: warning: exact test differs from ROSE: "
+                    << statementPosition(ref.r1.stmt) << " -> " << statementPosition(ref.r2.stmt) << std::endl;
+          return r;
+        }
+      }
+      return d;
+    default: ;
+    }
+  }
+  return (options_ & Memo) ? computeMemo(anal, ref, deptype) :
+         adhoc_.ComputeArrayDep(anal, ref, deptype);
+}
+
+DepInfo DepTesting::computeMemo(DepInfoAnal &anal, const DepInfoAnal::StmtRefDep &ref, DepType deptype)
+{
+  std::string key = testKey(ref, deptype);
+  if (key.empty()) {
+    stats_.uncached++;
+    return adhoc_.ComputeArrayDep(anal, ref, deptype);
+  }
+
+  DepInfo ret;
+  if (globalCache().find(key, ret)) {
+    stats_.hits++;
+    return rebind(ret, ref);
+  }
+  ret = adhoc_.ComputeArrayDep(anal, ref, deptype);
+  globalCache().insert(key, ret);
+  XD("key = " << key);
+  return ret;
+}
+
+size_t DepTesting::cacheSize()
+{ return globalCache().size(); }
+
+// EOF
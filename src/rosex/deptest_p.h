@@ -0,0 +1,134 @@
+#ifndef _ROSEX_DEPTEST_P_H
+#define _ROSEX_DEPTEST_P_H
+
+// deptest_p.h
+// 10/18/2026 jichi
+// Internal header for the array dependence tests of the dependence graph.
+
+#include "rosex/rose_config.h"
+#include "rosex/depexact_p.h"
+#include "xt/c++11.h"
+#include <DepInfoAnal.h>
+#include <boost/unordered_set.hpp>
+#include <utility>
+#include <vector>
+
+class AnalysisBudget;
+
+///  \internal  Counters of the array dependence tests of a graph.
+struct DepTestStatistics
+{
+  size_t tests,     ///< array dependence tests requested by ROSE
+         hits,      ///< tests answered by the cache
+         uncached,  ///< tests whose references could not be put into canonical form
+         filtered,  ///< tests proven independent by the filter
+         mismatches,///< filtered tests for which ROSE reports a dependence when verified
+         exact,     ///< tests answered by DepExactTest
+         exactMismatches, ///< exact tests inconsistent with ROSE when verified
+         deferred,  ///< tests postponed with Defer, counted again when run
+         demandedPairs; ///< statement pairs of the deferred tests computed on demand
+
+  DepTestStatistics()
+    : tests(0), hits(0), uncached(0), filtered(0), mismatches(0), exact(0), exactMismatches(0),
+      deferred(0), demandedPairs(0) {}
+
+  DepTestStatistics &operator+=(const DepTestStatistics &that)
+  {
+    tests += that.tests;
+    hits += that.hits;
+    uncached += that.uncached;
+    filtered += that.filtered;
+    mismatches += that.mismatches;
+    exact += that.exact;
+    exactMismatches += that.exactMismatches;
+    deferred += that.deferred;
+    demandedPairs += that.demandedPairs;
+    return *this;
+  }
+};
+
+/**
+ *  \internal
+ *  \brief  Array dependence testing of DepGraph, on top of AdhocDependenceTesting.
+ *
+ *  With Filter, each test first tries cheap tests that only answer when the
+ *  two references are proven independent:
+ *  - Distinct arrays by name, for declared C arrays other than parameters and
+ *    extern declarations
+ *  - GCD and Banerjee bounds tests on each dimension of affine subscripts of
+ *    the same array, in the variables of the canonical enclosing loops
+ *  Otherwise the test falls back to ROSE. With Verify, ROSE is still called
+ *  for the filtered tests, and any dependence it reports is a mismatch.
+ *
+ *  With Exact, the tests not filtered are then tried by DepExactTest, which
+ *  answers exactly for affine references, or falls back to the rest. With
+ *  VerifyExact, ROSE is still called for the tests answered exactly, and the
+ *  answer is a mismatch if ROSE proves independence, or any loop relation is
+ *  not within the one of ROSE, such as of the wrong sign or alignment. The
+ *  answer of ROSE is then used.
+ *
+ *  With Memo, each test is keyed by a canonical form of the two references
+ *  and of the headers of their enclosing loops, in which the variables are
+ *  numbered by their first occurrences. Tests of the same key are answered by
+ *  a copy of the DepInfo computed by ROSE, with the references replaced by the
+ *  ones under test. The cache is shared by all graphs in the process and is
+ *  thread-safe. The key also has the alias, side effect, and array interfaces
+ *  installed by the AnalysisContext::Scope of the caller, so that graphs with
+ *  different interfaces never share results. References with function calls
+ *  or non-integer constants are not cached.
+ *
+ *  With Defer, the tests not filtered are answered independent, and the pairs
+ *  of their statements are recorded to be computed later on demand.
+ *
+ *  If a budget is given, it is checked before each test, which throws
+ *  AnalysisBudget::Exceeded to abort the graph once exceeded.
+ */
+class DepTesting : public DependenceTesting
+{
+  typedef DepTesting Self;
+  typedef DependenceTesting Base;
+
+public:
+  enum Option {
+    Memo = 1,   ///< memoize the tests
+    Filter = 2, ///< try the cheap independence tests first
+    Verify = 4, ///< compare the filtered tests with ROSE
+    Exact = 8,  ///< try the integer set test of affine references
+    Defer = 16, ///< record the statements of the tests instead
+    VerifyExact = 32 ///< compare the exact tests with ROSE
+  };
+
+  typedef std::pair<SgNode *, SgNode *> StatementPair; ///< source and target
+
+private:
+  AdhocDependenceTesting adhoc_;
+  DepExactTest exact_;
+  DepTestStatistics stats_;
+  int options_;
+  const AnalysisBudget *budget_;
+  std::vector<StatementPair> deferred_; // in the order of the first test
+  boost::unordered_set<StatementPair> deferredSet_;
+
+public:
+  ///  \p options  Option flags, or 0 to only count the tests
+  explicit DepTesting(int options = 0, const AnalysisBudget *budget = nullptr)
+    : options_(options), budget_(budget) {}
+
+  DepInfo ComputeArrayDep(DepInfoAnal &anal, const DepInfoAnal::StmtRefDep &ref, DepType deptype) override;
+
+  const DepTestStatistics &statistics() const { return stats_; }
+
+  ///  Distinct statement pairs of the tests deferred with Defer.
+  const std::vector<StatementPair> &deferredPairs() const { return deferred_; }
+
+  ///  Return true if the two references are proven independent.
+  static bool independent(const DepInfoAnal::StmtRefDep &ref);
+
+  ///  Number of tests in the shared cache.
+  static size_t cacheSize();
+
+private:
+  DepInfo computeMemo(DepInfoAnal &anal, const DepInfoAnal::StmtRefDep &ref, DepType deptype);
+};
+
+#endif // _ROSEX_DEPTEST_P_H
@@ -9,6 +9,9 @@
 #include "rosex/loopdepgraph_p.h"
 #include <DepInfo.h> // for DepInfoSetEdge
 #include <boost/foreach.hpp>
+#include <boost/typeof/typeof.hpp>
+#include <boost/unordered_map.hpp>
+#include <algorithm>
 
 #define foreach BOOST_FOREACH
 
@@ -30,7 +33,9 @@ LoopDepGraph::~LoopDepGraph() { delete d_; }
 bool LoopDepGraph::init(SgNode *root, const option_type *option)
 {
   d_->clear();
+  d_->interfaces = AnalysisContext::Interfaces(option);
   if (Base::init(root, option)) {
+    AnalysisContext::Scope scope(d_->interfaces);
     d_->graph = new D::Graph(&Base::data()->graph);
 
     //D::Graph::NodeIterator p = Base::data()->graph.GetNodeIterator();
@@ -52,6 +57,12 @@ void LoopDepGraph::dumpLoopGraph() const
 
 // Queries
 
+size_t LoopFusionMatrix::index(const SgNode *loop) const
+{
+  BOOST_AUTO(p, indices_.find(loop));
+  return p == indices_.end() ? npos : p->second;
+}
+
 bool LoopDepGraph::fusible(const SgNode *upperLoop, const SgNode *lowerLoop) const
 {
   if (!d_->graph)
@@ -59,12 +70,13 @@ bool LoopDepGraph::fusible(const SgNode *upperLoop, const SgNode *lowerLoop) con
 
   SK_DPRINT("enter");
 
+  AnalysisContext::Scope scope(d_->interfaces);
   foreach (edge_type e, edges()) {
     vertex_type s = source(e),
                 t = target(e);
-    if (rosex::isAncestor(s.statement(), upperLoop) &&
-        rosex::isAncestor(t.statement(), lowerLoop) &&
-        distance(s, t) < 0) {
+    if (encloses(upperLoop, s) &&
+        encloses(lowerLoop, t) &&
+        transDistance(s, t) < 0) {
       SK_DPRINT("leave: ret = false");
       return false;
     }
@@ -73,7 +85,111 @@ bool LoopDepGraph::fusible(const SgNode *upperLoop, const SgNode *lowerLoop) con
   return true;
 }
 
+LoopFusionMatrix LoopDepGraph::fusibility(const std::vector<const SgNode *> &loops) const
+{
+  LoopFusionMatrix ret;
+  ret.loops_ = loops;
+  for (size_t i = 0; i < loops.size(); i++)
+    ret.indices_.insert(std::make_pair(loops[i], i));
+  ret.cells_.resize(loops.size() * loops.size());
+  if (!d_->graph) {
+    foreach (LoopFusionMatrix::Cell &c, ret.cells_)
+      c.fusible = false;
+    return ret;
+  }
+
+  SK_DPRINT("enter: loops = " << loops.size());
+
+  // Loops analyzed are found in the annotated chains, and the others by encloses()
+  const DepLoopNest &nest = Base::data()->graph.loopNest();
+  std::vector<size_t> others;
+  for (size_t i = 0; i < loops.size(); i++)
+    if (!nest.isLoop(loops[i]))
+      others.push_back(i);
+
+  // Loops enclosing each vertex, shared by the vertices in the same loops
+  const snapshot_type &s = snapshot();
+  std::vector<std::vector<size_t> > buckets;
+  std::vector<size_t> bucketOf(s.num_vertices(), LoopFusionMatrix::npos); // by the number of the vertex
+  boost::unordered_map<std::vector<size_t>, size_t> bucketIds;
+  for (size_t v = 0; v < s.num_vertices(); v++) {
+    const SgNode *stmt = s.vertex(v).statement();
+    std::vector<size_t> b;
+    DepLoopNest::loop_range r = nest.loops(stmt);
+    if (r.first == r.second && nest.level(stmt)) { // not annotated
+      for (size_t i = 0; i < loops.size(); i++)
+        if (encloses(loops[i], s.vertex(v)))
+          b.push_back(i);
+    } else {
+      for (; r.first != r.second; ++r.first) {
+        BOOST_AUTO(p, ret.indices_.find(*r.first));
+        if (p != ret.indices_.end())
+          b.push_back(p->second);
+      }
+      BOOST_AUTO(p, ret.indices_.find(stmt));
+      if (p != ret.indices_.end() && nest.isLoop(stmt) && (b.empty() || b.back() != p->second))
+        b.push_back(p->second);
+      foreach (size_t i, others)
+        if (encloses(loops[i], s.vertex(v)))
+          b.push_back(i);
+    }
+    if (b.empty())
+      continue;
+    BOOST_AUTO(p, bucketIds.insert(std::make_pair(b, buckets.size())));
+    if (p.second)
+      buckets.push_back(b);
+    bucketOf[v] = p.first->second;
+  }
+
+  // Reduce each edge to the pair of buckets of its end points, with the
+  // distances by the pair of vertices, as parallel edges share them
+  typedef std::pair<size_t, size_t> Pair;
+  AnalysisContext::Scope scope(d_->interfaces);
+  boost::unordered_map<Pair, int> distances;
+  boost::unordered_map<Pair, LoopFusionMatrix::Cell> pairs;
+  for (size_t e = 0; e < s.num_edges(); e++) {
+    const snapshot_type::EdgeRecord &r = s.record(e);
+    size_t upper = bucketOf[r.source],
+           lower = bucketOf[r.target];
+    if (upper == LoopFusionMatrix::npos || lower == LoopFusionMatrix::npos)
+      continue;
+
+    Pair key(r.source, r.target);
+    BOOST_AUTO(p, distances.find(key));
+    if (p == distances.end())
+      p = distances.insert(std::make_pair(key, transDistance(s.vertex(r.source), s.vertex(r.target)))).first;
+    int d = p->second;
+
+    LoopFusionMatrix::Cell &c = pairs[Pair(upper, lower)];
+    c.alignment = c.edges ? std::min(c.alignment, d) : d;
+    c.edges++;
+    if (d < 0)
+      c.fusible = false;
+  }
+
+  // Fold each pair of buckets into the pairs of the loops enclosing them
+  typedef std::pair<const Pair, LoopFusionMatrix::Cell> PairCell;
+  foreach (const PairCell &p, pairs)
+    foreach (size_t i, buckets[p.first.first])
+      foreach (size_t j, buckets[p.first.second]) {
+        LoopFusionMatrix::Cell &c = ret.cell(i, j);
+        c.alignment = c.edges ? std::min(c.alignment, p.second.alignment) : p.second.alignment;
+        c.edges += p.second.edges;
+        c.fusible = c.fusible && p.second.fusible;
+      }
+  SK_DPRINT("leave: distances = " << distances.size() << ", bucket pairs = " << pairs.size());
+  return ret;
+}
+
 int LoopDepGraph::distance(vertex_type v1, vertex_type v2) const
+{
+  if (!d_->graph)
+    return 0;
+  AnalysisContext::Scope scope(d_->interfaces); // ROSE reads the process-wide statics
+  return transDistance(v1, v2);
+}
+
+int LoopDepGraph::transDistance(vertex_type v1, vertex_type v2) const
 {
   if (!d_->graph)
     return 0;
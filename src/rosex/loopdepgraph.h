@@ -4,6 +4,55 @@
 // loopdepgraph.h
 // 4/16/2014 jichi
 #include "rosex/depgraph.h"
+#include <boost/unordered_map.hpp>
+#include <vector>
+
+/**
+ *  \brief  Fusibility and alignment of all ordered pairs of loops.
+ *
+ *  Returned by LoopDepGraph::fusibility(). For the loops numbered i and j,
+ *  fusible(i, j) is the same as LoopDepGraph::fusible(loop(i), loop(j)), and
+ *  alignment(i, j) is the minimum distance of the dependences from the
+ *  statements in loop(i) to the statements in loop(j), or 0 if none.
+ */
+class LoopFusionMatrix
+{
+  friend class LoopDepGraph;
+  typedef LoopFusionMatrix Self;
+
+public:
+  static const size_t npos = size_t(-1);
+
+  ///  Number of loops.
+  size_t size() const { return loops_.size(); }
+
+  const SgNode *loop(size_t i) const { return loops_[i]; }
+
+  ///  Return the number of \p loop, or npos if not in the matrix.
+  size_t index(const SgNode *loop) const;
+
+  bool fusible(size_t upper, size_t lower) const { return cell(upper, lower).fusible; }
+  int alignment(size_t upper, size_t lower) const { return cell(upper, lower).alignment; }
+
+  ///  Number of dependences from the statements in \p upper to the statements in \p lower.
+  size_t num_edges(size_t upper, size_t lower) const { return cell(upper, lower).edges; }
+
+private:
+  struct Cell {
+    size_t edges;
+    int alignment;
+    bool fusible;
+
+    Cell() : edges(0), alignment(0), fusible(true) {}
+  };
+
+  const Cell &cell(size_t upper, size_t lower) const { return cells_[upper * loops_.size() + lower]; }
+  Cell &cell(size_t upper, size_t lower) { return cells_[upper * loops_.size() + lower]; }
+
+  std::vector<const SgNode *> loops_;
+  boost::unordered_map<const SgNode *, size_t> indices_;
+  std::vector<Cell> cells_; // by upper * size() + lower
+};
 
 class LoopDepGraphPrivate;
 class LoopDepGraph : public DepGraph
@@ -33,12 +82,36 @@ public:
    */
   bool fusible(const SgNode *upperLoop, const SgNode *lowerLoop) const;
 
+  /**
+   *  \brief  Fusibility of all ordered pairs of \p loops in one pass over the edges.
+   *
+   *  The vertices are bucketed by the set of loops enclosing them, and each
+   *  edge only updates the pair of the buckets of its end points. Each pair of
+   *  buckets is then folded once into the pairs of the loops enclosing them,
+   *  so that the cost is one sweep over the edges plus one per pair of
+   *  buckets, rather than one per edge and loop pair. The transitive distance
+   *  is computed once per pair of vertices with edges, as it relates the
+   *  statements rather than their loops.
+   *
+   *  @param  loops  loops in the code, such as adjacent loops of a function
+   *  @return  all pairs are not fusible if the graph is not valid
+   */
+  LoopFusionMatrix fusibility(const std::vector<const SgNode *> &loops) const;
+
   /**
    * @param  v1  vertex in the upper loop
    * @param  v2  vertex in the lower loop
    * @return  distance between index variables
    */
   int distance(vertex_type v1, vertex_type v2) const;
+
+private:
+  ///  distance() with the interfaces of the graph already installed by the caller.
+  int transDistance(vertex_type v1, vertex_type v2) const;
+
+protected:
+  ///  \reimp  The transitive dependences are computed from the loop relations on demand.
+  bool compactible() const override { return false; }
 };
 
 
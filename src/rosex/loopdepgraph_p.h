@@ -5,6 +5,7 @@
 // 4/16/2014 jichi
 
 #include "rosex/depgraph_p.h"
+#include "rosex/depgraphopt_p.h"
 //#include <LoopTreeDepComp.h>
 #include <TransDepGraph.h>
 #include <TransDepGraphImpl.h>
@@ -14,6 +15,7 @@ class LoopDepGraphPrivate
 public:
   typedef TransDepGraphCreate<DepGraphNode> Graph;
   Graph *graph;
+  AnalysisContext::Interfaces interfaces; // installed when querying the transitive dependences
 
   LoopDepGraphPrivate() : graph(nullptr) {}
   ~LoopDepGraphPrivate() { clear(); }
@@ -0,0 +1,126 @@
+// loopnest_p.cc
+// 10/18/2026 jichi
+
+#include "rosex/rosex.h"
+#include "rosex/loopnest_p.h"
+#include <boost/foreach.hpp>
+#include <boost/typeof/typeof.hpp>
+
+#define foreach BOOST_FOREACH
+
+namespace { // anonymous
+
+  // Consistent with DepGraphNode::isLoop
+  inline bool isAnalyzableLoop(const SgNode *node)
+  { return node && rosex::isCanonicalLoop(node); }
+
+} // anonymous namespace
+
+// - Construction -
+
+void DepLoopNest::build(SgNode *root)
+{
+  root_ = root;
+  infos_.clear();
+  innerChains_.clear();
+  chains_.clear();
+  if (root) {
+    // Parents are annotated before children in preorder
+    foreach (SgNode *stmt, NodeQuery::querySubTree(root, V_SgStatement))
+      annotate(stmt);
+  }
+}
+
+DepLoopNest::Info DepLoopNest::annotate(const SgNode *node)
+{
+  BOOST_AUTO(p, infos_.find(node));
+  if (p != infos_.end())
+    return p->second;
+
+  Info ret;
+  ret.level = 0;
+  ret.loop = isAnalyzableLoop(node);
+  ret.chain = 0;
+  const SgNode *parent = node == root_ ? nullptr : node->get_parent();
+  if (parent) {
+    Info up = annotate(parent);
+    ret.level = up.level;
+    ret.chain = up.chain;
+    if (up.loop) {
+      ret.level++;
+      BOOST_AUTO(q, innerChains_.find(parent));
+      if (q != innerChains_.end())
+        ret.chain = q->second;
+      else {
+        ret.chain = chains_.size();
+        for (int i = 0; i < up.level; i++) {
+          const SgNode *loop = chains_[up.chain + i];
+          chains_.push_back(loop);
+        }
+        chains_.push_back(parent);
+        innerChains_[parent] = ret.chain;
+      }
+    }
+  }
+  infos_[node] = ret;
+  return ret;
+}
+
+// - Queries -
+
+const DepLoopNest::Info *DepLoopNest::find(const SgNode *node) const
+{
+  BOOST_AUTO(p, infos_.find(node));
+  return p == infos_.end() ? nullptr : &p->second;
+}
+
+int DepLoopNest::level(const SgNode *stmt) const
+{
+  if (const Info *i = find(stmt))
+    return i->level;
+  // Not annotated, such as a node outside of the root
+  int ret = 0;
+  if (stmt && stmt != root_)
+    for (const SgNode *p = stmt->get_parent(); p; p = p == root_ ? nullptr : p->get_parent())
+      if (isAnalyzableLoop(p))
+        ret++;
+  return ret;
+}
+
+bool DepLoopNest::isLoop(const SgNode *stmt) const
+{
+  const Info *i = find(stmt);
+  return i ? i->loop : isAnalyzableLoop(stmt);
+}
+
+DepLoopNest::loop_range DepLoopNest::loops(const SgNode *stmt) const
+{
+  const Info *i = find(stmt);
+  if (!i || !i->level)
+    return loop_range(nullptr, nullptr);
+  const SgNode * const *begin = &chains_[i->chain];
+  return loop_range(begin, begin + i->level);
+}
+
+bool DepLoopNest::encloses(const SgNode *loop, const SgNode *stmt) const
+{
+  if (loop == stmt)
+    return stmt != nullptr;
+  const Info *l = find(loop),
+             *s = find(stmt);
+  if (l && s && l->loop)
+    return s->level > l->level && chains_[s->chain + l->level] == loop;
+  return rosex::isAncestor(stmt, loop);
+}
+
+const SgNode *DepLoopNest::commonLoop(const SgNode *s1, const SgNode *s2) const
+{
+  loop_range r1 = loops(s1),
+             r2 = loops(s2);
+  const SgNode *ret = nullptr;
+  for (; r1.first != r1.second && r2.first != r2.second && *r1.first == *r2.first; ++r1.first, ++r2.first)
+    ret = *r1.first;
+  return ret;
+}
+
+// EOF
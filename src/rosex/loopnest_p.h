@@ -0,0 +1,72 @@
+#ifndef _ROSEX_LOOPNEST_P_H
+#define _ROSEX_LOOPNEST_P_H
+
+// loopnest_p.h
+// 10/18/2026 jichi
+// Internal header for loop nesting of depgraph statements.
+
+#include "rosex/rose_config.h"
+#include <boost/unordered_map.hpp>
+#include <utility>
+#include <vector>
+
+class SgNode;
+
+/**
+ *  \internal
+ *  \brief  Loops enclosing the statements under an AST root.
+ *
+ *  The statements are annotated in one pass over the root when the graph is
+ *  built, so that the loop level and the enclosing loops are looked up rather
+ *  than computed by walking the parents. Loops are counted up to and
+ *  including the root, consistent with DepGraphNode::levelOf.
+ *
+ *  Nodes not annotated are computed on demand without being cached, so that
+ *  the queries remain const after the build.
+ */
+class DepLoopNest
+{
+  typedef DepLoopNest Self;
+
+public:
+  typedef std::pair<const SgNode * const *, const SgNode * const *> loop_range;
+
+  DepLoopNest() : root_(nullptr) {}
+
+  ///  Annotate all statements under \p root, or clear if \p root is null.
+  void build(SgNode *root);
+
+  SgNode *root() const { return root_; }
+
+  ///  Number of enclosing loops of \p stmt.
+  int level(const SgNode *stmt) const;
+
+  ///  If \p stmt is a loop that could be analyzed.
+  bool isLoop(const SgNode *stmt) const;
+
+  ///  Enclosing loops of \p stmt from the outermost, or an empty range if not annotated.
+  loop_range loops(const SgNode *stmt) const;
+
+  ///  Return if \p stmt is \p loop or inside \p loop, same as rosex::isAncestor(stmt, loop).
+  bool encloses(const SgNode *loop, const SgNode *stmt) const;
+
+  ///  Innermost loop enclosing both statements, or null.
+  const SgNode *commonLoop(const SgNode *s1, const SgNode *s2) const;
+
+private:
+  struct Info {
+    int level;      // number of enclosing loops
+    bool loop;      // if the node itself is a loop
+    size_t chain;   // enclosing loops are chains_[chain, chain + level)
+  };
+
+  const Info *find(const SgNode *node) const;
+  Info annotate(const SgNode *node);
+
+  SgNode *root_;
+  boost::unordered_map<const SgNode *, Info> infos_;
+  boost::unordered_map<const SgNode *, size_t> innerChains_; // chain of the loop and its enclosing loops
+  std::vector<const SgNode *> chains_;
+};
+
+#endif // _ROSEX_LOOPNEST_P_H
@@ -0,0 +1,116 @@
+#ifndef _ROSEX_NODESET_H
+#define _ROSEX_NODESET_H
+
+// nodeset.h
+// 10/18/2026 jichi
+// Dense numbering and bitsets of AST nodes.
+
+#include "xt/c++11.h"
+#include <boost/dynamic_bitset.hpp>
+#include <boost/unordered/unordered_map.hpp>
+#include <vector>
+
+class SgNode;
+
+/**
+ *  \brief  Dense numbering of AST nodes starting from 0.
+ *
+ *  Nodes are numbered in the order they are inserted, and the numbers are
+ *  never reused. Only the nodes inserted could be looked up.
+ */
+class NodeIndex
+{
+  typedef NodeIndex Self;
+  typedef boost::unordered_map<const SgNode *, size_t> map_type;
+
+  map_type ids_;
+  std::vector<const SgNode *> nodes_;
+
+public:
+  static const size_t npos = size_t(-1);
+
+  size_t size() const { return nodes_.size(); }
+  bool empty() const { return nodes_.empty(); }
+
+  ///  Return the number of \p node, or npos if not inserted.
+  size_t find(const SgNode *node) const
+  {
+    map_type::const_iterator p = ids_.find(node);
+    return p == ids_.end() ? npos : p->second;
+  }
+
+  ///  Return the number of \p node, and number it if not inserted.
+  size_t insert(const SgNode *node)
+  {
+    std::pair<map_type::iterator, bool> p = ids_.insert(map_type::value_type(node, nodes_.size()));
+    if (p.second)
+      nodes_.push_back(node);
+    return p.first->second;
+  }
+
+  const SgNode *node(size_t id) const { return nodes_[id]; }
+
+  void reserve(size_t n) { ids_.rehash(n); nodes_.reserve(n); }
+};
+
+/**
+ *  \brief  Set of AST nodes numbered by a NodeIndex.
+ *
+ *  Membership is a bit test once the number is known, and the set operations
+ *  between sets of the same index are word-parallel. The index must outlive
+ *  the set. A set without an index is empty.
+ */
+class NodeBitSet
+{
+  typedef NodeBitSet Self;
+  typedef boost::dynamic_bitset<> bitset_type;
+
+  const NodeIndex *index_;
+  bitset_type bits_;
+
+public:
+  explicit NodeBitSet(const NodeIndex *index = nullptr)
+    : index_(index), bits_(index ? index->size() : 0) {}
+
+  const NodeIndex *index() const { return index_; }
+
+  ///  Grow to the size of the index if more nodes were numbered.
+  void resize() { if (index_ && bits_.size() < index_->size()) bits_.resize(index_->size()); }
+
+  ///  Number of nodes in the set.
+  size_t count() const { return bits_.count(); }
+  bool empty() const { return bits_.none(); }
+
+  bool test(size_t id) const { return id < bits_.size() && bits_.test(id); }
+  bool contains(const SgNode *node) const
+  { return index_ && test(index_->find(node)); }
+
+  ///  Return false if \p id was already in the set.
+  bool insert(size_t id)
+  {
+    if (bits_.test(id))
+      return false;
+    bits_.set(id);
+    return true;
+  }
+
+  void clear() { bits_.reset(); }
+
+  ///  Union with a set of the same index.
+  Self &operator|=(const Self &that) { bits_ |= that.bits_; return *this; }
+  ///  Intersection with a set of the same index.
+  Self &operator&=(const Self &that) { bits_ &= that.bits_; return *this; }
+  ///  Return if the sets of the same index have common nodes.
+  bool intersects(const Self &that) const { return bits_.intersects(that.bits_); }
+  ///  Return if this set is a subset of a set of the same index.
+  bool is_subset_of(const Self &that) const { return bits_.is_subset_of(that.bits_); }
+
+  ///  Append the nodes in the set in the order of numbering.
+  void nodes(std::vector<const SgNode *> &out) const
+  {
+    for (size_t i = bits_.find_first(); i != bitset_type::npos; i = bits_.find_next(i))
+      out.push_back(index_->node(i));
+  }
+};
+
+#endif // _ROSEX_NODESET_H
@@ -6,7 +6,9 @@
 
 #include "rosex/rose_config.h"
 #include <rose.h>
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 namespace rosex {
 
@@ -49,6 +51,57 @@ inline bool isCanonicalLoop(
 inline bool isCanonicalLoop(const SgNode *loop)
 { return isCanonicalLoop(const_cast<SgNode *>(loop)); }
 
+///  Get the for and do loops enclosing the statement in its function from the outermost.
+///  Return false if it is also in while loops.
+inline bool getEnclosingLoops(SgNode *stmt, std::vector<SgNode *> &ret)
+{
+  for (SgNode *p = stmt ? stmt->get_parent() : nullptr; p && !::isSgFunctionDefinition(p); p = p->get_parent())
+    switch (p->variantT()) {
+    case V_SgForStatement:
+    case V_SgFortranDo:
+      ret.push_back(p);
+      break;
+    case V_SgWhileStmt:
+    case V_SgDoWhileStmt:
+      return false;
+    default: ;
+    }
+  std::reverse(ret.begin(), ret.end());
+  return true;
+}
+
+///  Return the array variable of the reference, and get its subscripts from the leftmost dimension.
+inline const SgInitializedName *getArrayAccess(SgNode *ref, std::vector<SgExpression *> &subscripts)
+{
+  SgExpression *e = ::isSgExpression(ref);
+  while (SgPntrArrRefExp *a = ::isSgPntrArrRefExp(e)) {
+    SgExpression *rhs = a->get_rhs_operand();
+    if (SgExprListExp *l = ::isSgExprListExp(rhs)) // Fortran
+      subscripts.insert(subscripts.begin(), l->get_expressions().begin(), l->get_expressions().end());
+    else
+      subscripts.insert(subscripts.begin(), rhs);
+    e = a->get_lhs_operand();
+  }
+  SgVarRefExp *v = ::isSgVarRefExp(e);
+  SgVariableSymbol *s = v ? v->get_symbol() : nullptr;
+  return s ? s->get_declaration() : nullptr;
+}
+
+///  Return if the variable is an array that always denotes the same storage,
+///  i.e. not a pointer, a C array parameter, or an extern declaration.
+inline bool isDeclaredArray(const SgInitializedName *var, bool fortran)
+{
+  SgType *t = var ? var->get_type() : nullptr;
+  if (!t || !::isSgArrayType(t->stripTypedefsAndModifiers()))
+    return false;
+  if (fortran) // dummy arrays are not assignable
+    return true;
+  if (::isSgFunctionParameterList(var->get_parent()))
+    return false;
+  SgDeclarationStatement *decl = const_cast<SgInitializedName *>(var)->get_declaration();
+  return !decl || !decl->get_declarationModifier().get_storageModifier().isExtern();
+}
+
 
 ///  Return if the input a floating point SgType (float,double,real,...)
 inline bool isRealType(const SgNode *src)
@@ -19,11 +19,20 @@ HEADERS   += \
   $$PWD/defusegraph.h \
   $$PWD/depgraph.h \
   $$PWD/depgraph_p.h \
+  $$PWD/depgraphfile.h \
   $$PWD/depgraphbuilder_p.h \
+  $$PWD/depgrapharena_p.h \
   $$PWD/depgraphnode_p.h \
   $$PWD/depgraphopt_p.h \
+  $$PWD/depslice.h \
+  $$PWD/approxdepgraph.h \
+  $$PWD/budget.h \
+  $$PWD/deptest_p.h \
+  $$PWD/depexact_p.h \
   $$PWD/loopdepgraph.h \
   $$PWD/loopdepgraph_p.h \
+  $$PWD/loopnest_p.h \
+  $$PWD/nodeset.h \
   $$PWD/slice_p.h \
   $$PWD/symbolic.h \
   $$PWD/tac.h
@@ -32,10 +41,18 @@ SOURCES   += \
   $$PWD/defusegraph.cc \
   $$PWD/depgraph.cc \
   $$PWD/depgraph_p.cc \
+  $$PWD/depgraphfile.cc \
   $$PWD/depgraphopt_p.cc \
+  $$PWD/depslice.cc \
+  $$PWD/approxdepgraph.cc \
+  $$PWD/budget.cc \
+  $$PWD/deptest_p.cc \
+  $$PWD/depexact_p.cc \
   $$PWD/depgraphbuilder_p.cc \
+  $$PWD/depgrapharena_p.cc \
   $$PWD/depgraphnode_p.cc \
   $$PWD/loopdepgraph.cc \
+  $$PWD/loopnest_p.cc \
   $$PWD/slice_p.cc \
   $$PWD/symbolic.cc \
   $$PWD/tac.cc
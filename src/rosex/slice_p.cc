@@ -2,16 +2,11 @@
 // 6/17/2011 jichi
 
 #include "rosex/slice_p.h"
-#include <LoopTransformInterface.h>
 
-AstInterface *slice::globalAstInterface()
+boost::shared_mutex &slice::globalAnalysisMutex()
 {
-  static AstInterfaceImpl dummyImpl(nullptr);
-  static AstInterface ret(&dummyImpl);
-  static AssumeNoAlias aliasInfo;
-  LoopTransformInterface::set_astInterface(ret);
-  LoopTransformInterface::set_aliasInfo(&aliasInfo);
-  return &ret;
+  static boost::shared_mutex ret;
+  return ret;
 }
 
 // EOF
@@ -8,6 +8,7 @@
 #include "rosex/rose_config.h"
 #include <vector> // needed by <rose/AstInterface_ROSE> orz
 #include <AstInterface_ROSE.h>
+#include <boost/thread/shared_mutex.hpp>
 
 ///  \internal  Helpers to adapt bad-written slice headers in ROSE.
 namespace slice {
@@ -30,7 +31,15 @@ namespace slice {
   astnode_cast<AstNodePtr>(const SgNode *input)
   { return astnode_cast<AstNodePtr>(const_cast<SgNode*>(input)); }
 
-  AstInterface *globalAstInterface();
+  /**
+   *  \brief  Lock for ROSE analysis relying on process-wide statics.
+   *
+   *  The statics of LoopTransformInterface are shared by the entire process.
+   *  Analyses only reading them hold the shared lock, see AnalysisContext.
+   *  Analyses writing them, or not known to be thread-safe such as the
+   *  def-use analysis, hold the unique lock.
+   */
+  boost::shared_mutex &globalAnalysisMutex();
 
 } // namespace slice
 
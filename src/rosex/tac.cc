@@ -428,11 +428,13 @@ public:
 bool TacTable::Reference::isTemporary() const
 { return boost::starts_with(symbol, DFT_TEMP_PREFIX); }
 
+static int tempCount_ = 0; // number of temporary references created
+
+int TacTable::Reference::tempCount() { return tempCount_; }
+void TacTable::Reference::setTempCount(int val) { tempCount_ = val; }
+
 TacTable::Reference TacTable::Reference::createTemp(SgNode *src)
-{
-  static int id = 0;
-  return Reference(DFT_TEMP_PREFIX + boost::lexical_cast<std::string>(++id), src);
-}
+{ return Reference(DFT_TEMP_PREFIX + boost::lexical_cast<std::string>(++tempCount_), src); }
 
 TacTable::Reference TacTable::Reference::createSymbol(SgNode *src)
 { return Reference(SymbolicValue::fromSource(src), src); }
@@ -4,6 +4,7 @@
 #include "sk/skbuilder.h"
 #include "sk/skbuilder_p.h"
 #include "sk/sknode.h"
+#include "rosex/nodeset.h"
 #include "xt/xt.h"
 //#include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string.hpp>
@@ -306,11 +307,12 @@ SkStatement *SkBuilder::fromDeclaration(SgNode *input, const Option *opt)
   case V_SgVariableDeclaration:
     if (!SageInterface::is_Fortran_language() && opt && opt->criticalReferences) {
       bool critical = false;
-      const boost::unordered_set<const SgNode *> &refs = *opt->criticalReferences;
+      const NodeBitSet &refs = *opt->criticalReferences;
+      const NodeIndex &index = *opt->criticalIndex;
       foreach (SgNode *var, ::isSgVariableDeclaration(input)->get_variables())
         if (rosex::isArrayReference(var) ||
             rosex::isArrayType(::isSgInitializedName(var)->get_type()) ||
-            refs.count(input) || refs.count(var)) {
+            refs.test(index.find(input)) || refs.test(index.find(var))) {
           critical = true;
           break;
         }
@@ -508,7 +510,8 @@ SkStatement *SkBuilder::fromStatement(SgNode *input, const Option *opt)
 
   case V_SgExprStatement:
     if (opt && opt->criticalReferences) {
-      const boost::unordered_set<const SgNode *> &refs = *opt->criticalReferences;
+      const NodeBitSet &refs = *opt->criticalReferences;
+      const NodeIndex &index = *opt->criticalIndex;
       SgExpression *lhs, *rhs;
       if (SageInterface::isAssignmentStatement(input, &lhs, &rhs) &&
           !::isSgAggregateInitializer(rhs) &&
@@ -516,7 +519,7 @@ SkStatement *SkBuilder::fromStatement(SgNode *input, const Option *opt)
           //!rosex::isFortranArraySubscript(lhs) &&
           (
             rosex::isArrayReference(lhs) ||
-            !refs.count(input) && !refs.count(lhs))
+            !refs.test(index.find(input)) && !refs.test(index.find(lhs)))
           ) {
         SK_DPRINT("leave: skip redundant assignment ");
         return nullptr;
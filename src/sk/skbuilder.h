@@ -12,6 +12,8 @@
 #include <boost/unordered/unordered_set.hpp>
 
 class SgNode;
+class NodeBitSet;
+class NodeIndex;
 
 SK_BEGIN_NAMESPACE
 
@@ -41,7 +43,10 @@ namespace SkBuilder {
      *  - When the value is a non-empty set, only the references in the set
      *  are considered as critical.
      */
-    boost::unordered_set<const SgNode *> *criticalReferences;
+    const NodeBitSet *criticalReferences;
+
+    ///  Numbering of the nodes in criticalReferences, which must be set with it.
+    const NodeIndex *criticalIndex;
 
     /**
      *  \brief  New name of the scalar variables.
@@ -67,7 +72,7 @@ namespace SkBuilder {
     // */
     //bool supportsInitializer;
 
-    Option() : criticalReferences(nullptr), variableNames(nullptr), danglingSlices(nullptr) {}
+    Option() : criticalReferences(nullptr), criticalIndex(nullptr), variableNames(nullptr), danglingSlices(nullptr) {}
   };
 
   //inline SkInteger *createInteger(int value = 0)
@@ -127,6 +132,36 @@ namespace SkBuilder {
   ///  Traverse src and apply devectorization recursively.
   SkNode *devectorize(SkNode *src);
 
+  /**
+   *  \brief  Counters used to generate unique names in the skeleton.
+   *
+   *  The counters are thread-local. A skeleton built in one thread starting
+   *  from zero counters could be moved into the global numbering afterwards
+   *  by renumber(), which makes the output independent of the threads.
+   */
+  struct Counters {
+    int blockBarriers;  ///< number of SkBlockBarrier created
+    int tempScalars;    ///< number of temporary scalar created
+
+    Counters() : blockBarriers(0), tempScalars(0) {}
+
+    Counters &operator+=(const Counters &that)
+    {
+      blockBarriers += that.blockBarriers;
+      tempScalars += that.tempScalars;
+      return *this;
+    }
+  };
+
+  ///  Return counters of the current thread.
+  Counters counters();
+
+  ///  Set counters of the current thread.
+  void setCounters(const Counters &val);
+
+  ///  Shift block barrier ids and temporary scalar names in src by offset.
+  void renumber(SkNode *src, const Counters &offset);
+
 } // namespace SkBuilder
 
 SK_END_NAMESPACE
@@ -3,6 +3,7 @@
 
 #include "sk/skbuilder_p.h"
 #include "sk/sknode.h"
+#include "sk/skquery.h"
 #include <boost/lexical_cast.hpp>
 
 #define SK_DEBUG "skbuilder_new"
@@ -11,14 +12,40 @@
 
 #define foreach BOOST_FOREACH
 
+#define TEMP_SCALAR_PREFIX  "_"
+
+namespace { // anonymous
+
+  SK_THREAD_LOCAL int tempScalarCount_ = 0;
+
+  // Return the number in the temporary scalar name, or 0 if it is not a temporary scalar.
+  int tempScalarId(const SkVariable *var)
+  {
+    if (!var->isTemporary())
+      return 0;
+    const std::string &name = var->name();
+    if (name.size() < 2 || name.compare(0, sizeof(TEMP_SCALAR_PREFIX) - 1, TEMP_SCALAR_PREFIX))
+      return 0;
+    int ret = 0;
+    for (size_t i = sizeof(TEMP_SCALAR_PREFIX) - 1; i < name.size(); i++)
+      if (name[i] < '0' || name[i] > '9')
+        return 0;
+      else
+        ret = ret * 10 + (name[i] - '0');
+    return ret;
+  }
+
+} // anonymous namespace
+
 SK_BEGIN_NAMESPACE
 
 SkVariable *SkBuilder::detail::createTempScalar(Sk::ScalarType type)
 {
-  static int count = 0;
-  count++;
-  std::string name = "_" + boost::lexical_cast<std::string>(count);
-  return createScalar(name, type);
+  tempScalarCount_++;
+  std::string name = TEMP_SCALAR_PREFIX + boost::lexical_cast<std::string>(tempScalarCount_);
+  SkVariable *ret = createScalar(name, type);
+  ret->setTemporary(true);
+  return ret;
 }
 
 SkVariable *SkBuilder::detail::createScalar(const std::string &name, Sk::ScalarType type, SgNode *src)
@@ -37,4 +64,37 @@ SkFunctionCall *SkBuilder::detail::createFunctionCall(const std::string &name, S
   return ret;
 }
 
+// - Counters -
+
+SkBuilder::Counters SkBuilder::counters()
+{
+  Counters ret;
+  ret.blockBarriers = SkBlockBarrier::counter();
+  ret.tempScalars = tempScalarCount_;
+  return ret;
+}
+
+void SkBuilder::setCounters(const Counters &val)
+{
+  SkBlockBarrier::setCounter(val.blockBarriers);
+  tempScalarCount_ = val.tempScalars;
+}
+
+void SkBuilder::renumber(SkNode *input, const Counters &offset)
+{
+  if (!input)
+    return;
+  if (offset.blockBarriers)
+    foreach (SkNode *it, SkQuery::find(input, Sk::C_BlockBarrier)) {
+      SkBlockBarrier *barrier = static_cast<SkBlockBarrier *>(it);
+      barrier->setId(barrier->id() + offset.blockBarriers);
+    }
+  if (offset.tempScalars)
+    foreach (SkNode *it, SkQuery::find(input, Sk::C_Variable)) {
+      SkVariable *var = static_cast<SkVariable *>(it);
+      if (int id = tempScalarId(var))
+        var->setName(TEMP_SCALAR_PREFIX + boost::lexical_cast<std::string>(id + offset.tempScalars));
+    }
+}
+
 SK_END_NAMESPACE
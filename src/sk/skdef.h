@@ -14,6 +14,15 @@
   Class(const Class &); \
   Class &operator=(const Class &);
 
+// Thread-local storage for POD statics, so that skeletons could be built concurrently.
+#if defined(__GNUC__) || defined(__clang__)
+#  define SK_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#  define SK_THREAD_LOCAL __declspec(thread)
+#else
+#  define SK_THREAD_LOCAL
+#endif // __GNUC__
+
 #ifndef SK_NO_DEBUG
 #  include <cassert>
 #  define SK_ASSERT(cond) assert(cond)
@@ -12,7 +12,7 @@ SK_BEGIN_NAMESPACE
 
 // - Static fields -
 
-int SkBlockBarrier::s_count_ = 0;
+SK_THREAD_LOCAL int SkBlockBarrier::s_count_ = 0;
 
 SkConf SkNode::conf_;
 
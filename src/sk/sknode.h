@@ -168,6 +168,7 @@ public:
   const std::string &comment() const { return comment_; }
   void setComment(const std::string &val) { comment_ = val; }
 
+  ///  Shared by all threads. It must be set before building skeletons concurrently.
   static const SkConf &configuration() { return conf_; }
   static void setConfiguration(const SkConf &val) { conf_ = val; }
 
@@ -438,15 +439,21 @@ public:
 class SkVariable : public SkSymbol
 {
   SK_NODE(Variable, Symbol)
+  bool temporary_;
 public:
-  explicit SkVariable(SgNode *src = nullptr) : Base(src) {}
+  explicit SkVariable(SgNode *src = nullptr) : Base(src), temporary_(false) {}
   SkVariable(const std::string &name, SkType *type, SgNode *src = nullptr)
-    : Base(name, type, src) {}
+    : Base(name, type, src), temporary_(false) {}
+
+  ///  If the variable is a temporary scalar created by the builder rather than from the source.
+  bool isTemporary() const { return temporary_; }
+  void setTemporary(bool t) { temporary_ = t; }
 
   Self *clone() const override
   {
     Self *ret = new Self(name(), type() ? type()->clone() : nullptr, source());
     if (value()) ret->setValue(value()->clone());
+    ret->setTemporary(temporary_);
     return ret;
   }
 };
@@ -1649,7 +1656,7 @@ protected:
 class SkBlockBarrier : public SkStatement
 {
   SK_NODE(BlockBarrier, Statement)
-  static int s_count_;
+  static SK_THREAD_LOCAL int s_count_; // per-thread, see SkBuilder::counters
   int id_;
   SgNode *begin_, *end_; // The starting and ending statement
 public:
@@ -1665,8 +1672,13 @@ public:
   ///  Reset the static counter of class instances
   static void resetCounter() { s_count_ = 0; }
 
+  ///  Number of instances created in the current thread
+  static int counter() { return s_count_; }
+  static void setCounter(int val) { s_count_ = val; }
+
   ///  Return the unique id of this block
   int id() const { return id_; }
+  void setId(int val) { id_ = val; }
 
   ///  The first statement of the basic block
   SgNode *beginSource() const { return begin_; }
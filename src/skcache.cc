@@ -0,0 +1,301 @@
+// skcache.cc
+// 10/18/2026 jichi
+
+#include "skcache.h"
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+
+#define DEBUG "skcache"
+#include "xt/xdebug.h"
+
+#define foreach BOOST_FOREACH
+
+#define CACHE_VERSION   "skcache 1"
+#define CACHE_SUFFIX    ".skc"
+#define TEMPLATE_MARK   '\x01'  // enclose the numbered names in templates
+
+namespace bf = boost::filesystem;
+
+namespace { // anonymous
+
+  enum { CounterCount = 4 };
+  const char CounterKinds[CounterCount + 1] = "btda"; // same order as counterAt
+
+  int &counterAt(SkCache::Counters &c, int i)
+  {
+    switch (i) {
+    case 0: return c.blockBarriers;
+    case 1: return c.tempScalars;
+    case 2: return c.dataflowTemps;
+    default: return c.tacTemps;
+    }
+  }
+
+  int counterAt(const SkCache::Counters &c, int i)
+  { return counterAt(const_cast<SkCache::Counters &>(c), i); }
+
+  ///  FNV-1a hash, used as the file name. Collisions are detected by comparing the keys.
+  std::string hashKey(const std::string &key)
+  {
+    boost::uint64_t h = 14695981039346656037ULL;
+    foreach (char ch, key) {
+      h ^= (unsigned char)ch;
+      h *= 1099511628211ULL;
+    }
+    std::ostringstream out;
+    out << std::hex << h << '-' << key.size();
+    return out.str();
+  }
+
+  ///  Write the string with its length, so that it could contain any characters.
+  void writeSection(std::ostream &out, const std::string &s)
+  { out << s.size() << '\n' << s; }
+
+  bool readSection(std::istream &in, std::string &s)
+  {
+    size_t size;
+    if (!(in >> size) || in.get() != '\n')
+      return false;
+    s.resize(size);
+    return size == 0 || in.read(&s[0], size);
+  }
+
+  ///  Cache entry on disk
+  struct EntryFile
+  {
+    bf::path path;
+    boost::uintmax_t size;
+    std::time_t time;
+
+    bool operator<(const EntryFile &that) const
+    { return time < that.time || (time == that.time && path < that.path); }
+  };
+
+} // anonymous namespace
+
+// - Counters -
+
+SkCache::Counters &SkCache::Counters::operator+=(const Counters &that)
+{
+  for (int i = 0; i < CounterCount; i++)
+    counterAt(*this, i) += counterAt(that, i);
+  return *this;
+}
+
+SkCache::Counters &SkCache::Counters::operator-=(const Counters &that)
+{
+  for (int i = 0; i < CounterCount; i++)
+    counterAt(*this, i) -= counterAt(that, i);
+  return *this;
+}
+
+// - Constructions -
+
+SkCache::SkCache(const std::string &dir, boost::uintmax_t maxSize)
+  : dir_(dir), maxSize_(maxSize), valid_(false)
+{
+  boost::system::error_code ec;
+  bf::create_directories(dir_, ec);
+  valid_ = bf::is_directory(dir_, ec);
+  if (!valid_)
+    std::cerr << "skcache:warning: cache directory is not available: " << dir_ << std::endl;
+}
+
+std::string SkCache::statisticsString() const
+{
+  std::ostringstream out;
+  out << "hits = " << stats_.hits
+      << ", misses = " << stats_.misses
+      << ", stores = " << stats_.stores
+      << ", rejects = " << stats_.rejects
+      << ", evictions = " << stats_.evictions;
+  return out.str();
+}
+
+// - Entries -
+
+bool SkCache::find(Entry &out, const std::string &key)
+{
+  if (!valid_)
+    return false;
+  bf::path path = bf::path(dir_) / (hashKey(key) + CACHE_SUFFIX);
+  std::ifstream in(path.string().c_str(), std::ios::binary);
+  std::string version, storedKey;
+  bool ok = in.is_open() &&
+      std::getline(in, version) && version == CACHE_VERSION &&
+      readSection(in, storedKey) && storedKey == key;
+  if (ok)
+    for (int i = 0; ok && i < CounterCount; i++)
+      ok = !!(in >> counterAt(out.counters, i));
+  ok = ok && in.get() == '\n' &&
+      readSection(in, out.skeleton) &&
+      readSection(in, out.dataflow) &&
+      readSection(in, out.tac);
+  if (!ok) {
+    stats_.misses++;
+    return false;
+  }
+  stats_.hits++;
+  // Touch the entry for LRU eviction
+  boost::system::error_code ec;
+  bf::last_write_time(path, std::time(nullptr), ec);
+  return true;
+}
+
+void SkCache::insert(const std::string &key, const Entry &entry)
+{
+  if (!valid_)
+    return;
+  std::string name = hashKey(key);
+  bf::path path = bf::path(dir_) / (name + CACHE_SUFFIX),
+           tmp = bf::path(dir_) / (name + ".tmp" + boost::lexical_cast<std::string>(::getpid()));
+  {
+    std::ofstream out(tmp.string().c_str(), std::ios::binary|std::ios::trunc);
+    if (!out.is_open())
+      return;
+    out << CACHE_VERSION << '\n';
+    writeSection(out, key);
+    for (int i = 0; i < CounterCount; i++)
+      out << (i ? " " : "") << counterAt(entry.counters, i);
+    out << '\n';
+    writeSection(out, entry.skeleton);
+    writeSection(out, entry.dataflow);
+    writeSection(out, entry.tac);
+  }
+  // Rename is atomic, so that concurrent processes never read partial entries
+  boost::system::error_code ec;
+  bf::rename(tmp, path, ec);
+  if (ec)
+    bf::remove(tmp, ec);
+  else
+    stats_.stores++;
+}
+
+void SkCache::prune()
+{
+  if (!valid_)
+    return;
+  boost::system::error_code ec;
+  std::vector<EntryFile> files;
+  boost::uintmax_t total = 0;
+  for (bf::directory_iterator p(dir_, ec), end; !ec && p != end; p.increment(ec))
+    if (p->path().extension() == CACHE_SUFFIX) {
+      EntryFile f;
+      f.path = p->path();
+      f.size = bf::file_size(f.path, ec);
+      f.time = bf::last_write_time(f.path, ec);
+      if (!ec) {
+        total += f.size;
+        files.push_back(f);
+      }
+      ec.clear();
+    }
+  XD("cache size = " << total << ", limit = " << maxSize_);
+  if (total <= maxSize_)
+    return;
+
+  std::sort(files.begin(), files.end());
+  foreach (const EntryFile &f, files) {
+    if (total <= maxSize_)
+      break;
+    if (bf::remove(f.path, ec)) // could be removed by another process
+      stats_.evictions++;
+    total -= f.size;
+  }
+}
+
+bool SkCache::makeEntry(Entry &out, const Entry &sentinelOutput)
+{
+  out.counters = sentinelOutput.counters;
+  bool ok = makeTemplate(out.skeleton, sentinelOutput.skeleton, out.counters) &&
+            makeTemplate(out.dataflow, sentinelOutput.dataflow, out.counters) &&
+            makeTemplate(out.tac, sentinelOutput.tac, out.counters);
+  if (!ok)
+    stats_.rejects++;
+  return ok;
+}
+
+// - Templates -
+
+const SkCache::Counters &SkCache::sentinels()
+{
+  static Counters ret;
+  if (!ret.blockBarriers) {
+    ret.blockBarriers = 100000000;
+    ret.tempScalars   = 200000000;
+    ret.dataflowTemps = 300000000;
+    ret.tacTemps      = 400000000;
+  }
+  return ret;
+}
+
+bool SkCache::makeTemplate(std::string &out, const std::string &text, const Counters &consumed)
+{
+  if (text.find(TEMPLATE_MARK) != std::string::npos)
+    return false;
+  const Counters &base = sentinels();
+  out.clear();
+  out.reserve(text.size());
+  for (size_t i = 0; i < text.size();) {
+    if (!::isdigit(text[i])) {
+      out.push_back(text[i++]);
+      continue;
+    }
+    size_t j = i;
+    while (j < text.size() && ::isdigit(text[j]))
+      j++;
+    bool found = false;
+    if (j - i < 12) {
+      long long value = std::atoll(text.substr(i, j - i).c_str());
+      for (int k = 0; !found && k < CounterCount; k++) {
+        long long id = value - counterAt(base, k);
+        if (id > 0 && id <= counterAt(consumed, k)) {
+          found = true;
+          out.push_back(TEMPLATE_MARK);
+          out.push_back(CounterKinds[k]);
+          out.append(boost::lexical_cast<std::string>(id));
+          out.push_back(TEMPLATE_MARK);
+        }
+      }
+    }
+    if (!found)
+      out.append(text, i, j - i);
+    i = j;
+  }
+  return true;
+}
+
+std::string SkCache::fill(const std::string &tmpl, const Counters &base)
+{
+  std::string ret;
+  ret.reserve(tmpl.size());
+  for (size_t i = 0; i < tmpl.size();) {
+    size_t j = tmpl.find(TEMPLATE_MARK, i);
+    if (j == std::string::npos) {
+      ret.append(tmpl, i, std::string::npos);
+      break;
+    }
+    ret.append(tmpl, i, j - i);
+    size_t end = tmpl.find(TEMPLATE_MARK, j + 1);
+    if (end == std::string::npos || end < j + 3)
+      break; // corrupted
+    int k = std::find(CounterKinds, CounterKinds + CounterCount, tmpl[j + 1]) - CounterKinds;
+    int id = std::atoi(tmpl.substr(j + 2, end - j - 2).c_str());
+    if (k < CounterCount)
+      ret.append(boost::lexical_cast<std::string>(counterAt(base, k) + id));
+    i = end + 1;
+  }
+  return ret;
+}
+
+// EOF
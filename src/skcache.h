@@ -0,0 +1,126 @@
+#ifndef SKCACHE_H
+#define SKCACHE_H
+
+// skcache.h
+// 10/18/2026 jichi
+// Persistent cache of the generated function skeletons.
+
+#include "sk/skdef.h"
+#include <boost/cstdint.hpp>
+#include <string>
+
+/**
+ *  \brief  Content-addressed on-disk cache of function outputs.
+ *
+ *  Each entry is keyed by the normalized source of a function together with
+ *  everything else that affects its output, and stores the skeleton, dataflow
+ *  and TAC sections of the function.
+ *
+ *  The sections contain names numbered by process-wide counters, such as
+ *  block barriers and temporary variables. They are stored as templates
+ *  relative to the counters before the function, so that an entry could be
+ *  replayed at any position in the output.
+ *
+ *  Entries are written atomically, so that the cache directory could be shared
+ *  by concurrent processes. When the directory exceeds the size limit, the
+ *  least recently used entries are evicted by prune().
+ */
+class SkCache
+{
+  SK_DISABLE_COPY(SkCache)
+  typedef SkCache Self;
+
+public:
+  ///  Counters numbering the names in the output.
+  struct Counters {
+    int blockBarriers;  ///< see SkBuilder::Counters
+    int tempScalars;    ///< see SkBuilder::Counters
+    int dataflowTemps;  ///< see DataFlowTable::Reference::tempCount
+    int tacTemps;       ///< see TacTable::Reference::tempCount
+
+    Counters() : blockBarriers(0), tempScalars(0), dataflowTemps(0), tacTemps(0) {}
+
+    Counters &operator+=(const Counters &that);
+    Counters &operator-=(const Counters &that);
+  };
+
+  ///  Output sections of a function with names relative to zero counters.
+  struct Entry {
+    Counters counters;    ///< counters consumed by the function
+    std::string skeleton; ///< template of the skeleton
+    std::string dataflow; ///< template of the dataflow section
+    std::string tac;      ///< template of the TAC section
+  };
+
+  struct Statistics {
+    size_t hits,
+           misses,
+           stores,
+           rejects,   ///< outputs that could not be converted to templates
+           evictions;
+
+    Statistics() : hits(0), misses(0), stores(0), rejects(0), evictions(0) {}
+  };
+
+  // - Constructions -
+public:
+  ///  Use \p dir as the cache directory, and limit its size to \p maxSize bytes.
+  SkCache(const std::string &dir, boost::uintmax_t maxSize);
+
+  ///  Return false if the cache directory is not available.
+  bool isValid() const { return valid_; }
+
+  const Statistics &statistics() const { return stats_; }
+
+  ///  Summary of the statistics in one line.
+  std::string statisticsString() const;
+
+  // - Entries -
+public:
+  ///  Load the entry of \p key. Return false if not found.
+  bool find(Entry &out, const std::string &key);
+
+  ///  Save the entry of \p key.
+  void insert(const std::string &key, const Entry &entry);
+
+  ///  Evict least recently used entries until the cache is below the size limit.
+  void prune();
+
+  /**
+   *  \brief  Convert the output of a function into an entry.
+   *  \param  sentinelOutput  output rendered from sentinels(), with consumed counters
+   *  \return  false if any section could not be converted into a template
+   *
+   *  The output from any counters is then rendered by fill() from the entry,
+   *  so that a function only needs to be rendered once.
+   */
+  bool makeEntry(Entry &out, const Entry &sentinelOutput);
+
+  // - Templates -
+public:
+  /**
+   *  \brief  Large counters to render the outputs for makeTemplate.
+   *
+   *  The names generated from the sentinels are unlikely to appear in the
+   *  source code, and are used to locate the numbered names in the output.
+   */
+  static const Counters &sentinels();
+
+  /**
+   *  \brief  Convert the text rendered from sentinels() into a template.
+   *  \param  consumed  counters consumed when rendering the text
+   *  \return  false if the text could not be converted
+   */
+  static bool makeTemplate(std::string &out, const std::string &text, const Counters &consumed);
+
+  ///  Render the template with names numbered after \p base.
+  static std::string fill(const std::string &tmpl, const Counters &base);
+
+private:
+  std::string dir_;
+  boost::uintmax_t maxSize_;
+  bool valid_;
+  Statistics stats_;
+};
+
+#endif // SKCACHE_H
@@ -0,0 +1,310 @@
+// skdriver.cc
+// 10/18/2026 jichi
+
+#include "skdriver.h"
+#include "xt/c++11.h"
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/unordered_map.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DEBUG "skdriver"
+#include "xt/xdebug.h"
+
+#define foreach BOOST_FOREACH
+
+namespace bf = boost::filesystem;
+namespace bp = boost::property_tree;
+
+namespace { // anonymous
+
+  ///  Split a shell command line into arguments. Only quotes and backslashes are handled.
+  std::vector<std::string> splitCommandLine(const std::string &line)
+  {
+    std::vector<std::string> ret;
+    std::string arg;
+    bool inArg = false;
+    char quote = 0;
+    for (size_t i = 0; i < line.size(); i++) {
+      char ch = line[i];
+      if (quote) {
+        if (ch == quote)
+          quote = 0;
+        else if (ch == '\\' && quote == '"' && i + 1 < line.size())
+          arg.push_back(line[++i]);
+        else
+          arg.push_back(ch);
+      } else if (ch == '"' || ch == '\'') {
+        quote = ch;
+        inArg = true;
+      } else if (ch == '\\' && i + 1 < line.size()) {
+        arg.push_back(line[++i]);
+        inArg = true;
+      } else if (::isspace(ch)) {
+        if (inArg) {
+          ret.push_back(arg);
+          arg.clear();
+          inArg = false;
+        }
+      } else {
+        arg.push_back(ch);
+        inArg = true;
+      }
+    }
+    if (inArg)
+      ret.push_back(arg);
+    return ret;
+  }
+
+  ///  Return the path of the source file in the command.
+  bf::path sourcePath(const SkDriver::Command &cmd)
+  {
+    bf::path ret(cmd.file);
+    if (ret.is_absolute() || cmd.directory.empty())
+      return ret;
+    return bf::path(cmd.directory) / ret;
+  }
+
+  ///  Remove the compiler, the output flags, and the source file from the compiler arguments.
+  std::vector<std::string> stripCompilerArguments(const std::vector<std::string> &args, const SkDriver::Command &cmd)
+  {
+    std::vector<std::string> ret;
+    bf::path src = sourcePath(cmd);
+    for (size_t i = 1; i < args.size(); i++) { // skip the compiler
+      const std::string &arg = args[i];
+      if (arg == "-c") // skgen would invoke the backend for -c
+        continue;
+      if (arg == "-o") {
+        i++;
+        continue;
+      }
+      if (arg == cmd.file)
+        continue;
+      if (!arg.empty() && arg[0] != '-') {
+        bf::path p(arg);
+        if (!p.is_absolute() && !cmd.directory.empty())
+          p = bf::path(cmd.directory) / p;
+        if (p == src)
+          continue;
+      }
+      ret.push_back(arg);
+    }
+    return ret;
+  }
+
+  ///  Size of the source file in bytes, or 0 if unknown.
+  size_t estimateSize(const SkDriver::Command &cmd)
+  {
+    boost::system::error_code ec;
+    boost::uintmax_t ret = bf::file_size(sourcePath(cmd), ec);
+    return ec ? 0 : ret;
+  }
+
+  ///  Larger files first, and keep the input order for files of the same size.
+  struct LargerCommand
+  {
+    const std::vector<SkDriver::Command> &commands;
+    explicit LargerCommand(const std::vector<SkDriver::Command> &c) : commands(c) {}
+    bool operator()(size_t x, size_t y) const
+    { return commands[x].sizeEstimate > commands[y].sizeEstimate; }
+  };
+
+  ///  Copy the content of the file to the stream if the file exists.
+  void appendFile(std::ostream &out, const bf::path &path)
+  {
+    std::ifstream in(path.string().c_str());
+    if (in.is_open() && in.peek() != std::ifstream::traits_type::eof())
+      out << in.rdbuf();
+  }
+
+  /**
+   *  Fork a worker process to skeletonize the command.
+   *  The standard output of the worker is redirected to \p outPath.
+   *  Return the pid of the worker, or -1 if failed.
+   */
+  pid_t spawn(const SkDriver::Command &cmd, const SkDriver::Option &option,
+              const bf::path &outPath, const bf::path &globalPath)
+  {
+    std::vector<std::string> args;
+    args.push_back(option.program);
+    args.insert(args.end(), option.arguments.begin(), option.arguments.end());
+    args.push_back("-sk:global=" + globalPath.string());
+    args.insert(args.end(), cmd.arguments.begin(), cmd.arguments.end());
+    args.push_back(cmd.file);
+
+    // Prepare argv before forking
+    std::vector<char *> argv;
+    foreach (std::string &arg, args)
+      argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+    std::string out = outPath.string();
+
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = ::fork();
+    if (pid)
+      return pid;
+
+    // Child process
+    if (!cmd.directory.empty() && ::chdir(cmd.directory.c_str())) {
+      std::perror(cmd.directory.c_str());
+      ::_exit(127);
+    }
+    int fd = ::open(out.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0 || ::dup2(fd, STDOUT_FILENO) < 0) {
+      std::perror(out.c_str());
+      ::_exit(127);
+    }
+    ::close(fd);
+    ::execvp(argv[0], &argv[0]);
+    std::perror(argv[0]);
+    ::_exit(127);
+    return -1; // unreachable
+  }
+
+} // anonymous namespace
+
+// - Load -
+
+bool SkDriver::loadCompileCommands(std::vector<Command> &out, const std::string &path)
+{
+  bp::ptree root;
+  try {
+    bp::read_json(path, root);
+  } catch (bp::json_parser_error &e) {
+    std::cerr << "skdriver:warning: failed to parse compilation database: " << e.what() << std::endl;
+    return false;
+  }
+
+  foreach (const bp::ptree::value_type &entry, root) {
+    Command cmd;
+    cmd.directory = entry.second.get<std::string>("directory", std::string());
+    cmd.file = entry.second.get<std::string>("file", std::string());
+    if (cmd.file.empty()) {
+      std::cerr << "skdriver:warning: missing file in compilation database: " << path << std::endl;
+      continue;
+    }
+
+    std::vector<std::string> args;
+    if (boost::optional<const bp::ptree &> a = entry.second.get_child_optional("arguments")) {
+      foreach (const bp::ptree::value_type &it, *a)
+        args.push_back(it.second.data());
+    } else
+      args = splitCommandLine(entry.second.get<std::string>("command", std::string()));
+
+    cmd.arguments = stripCompilerArguments(args, cmd);
+    cmd.sizeEstimate = estimateSize(cmd);
+    out.push_back(cmd);
+  }
+  XD("number of commands = " << out.size());
+  return true;
+}
+
+bool SkDriver::loadFileList(std::vector<Command> &out, const std::string &path)
+{
+  std::ifstream in(path.c_str());
+  if (!in.is_open()) {
+    std::cerr << "skdriver:warning: failed to open file list: " << path << std::endl;
+    return false;
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t first = line.find_first_not_of(" \t\r"),
+           last = line.find_last_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#')
+      continue;
+    Command cmd;
+    cmd.file = line.substr(first, last - first + 1);
+    cmd.sizeEstimate = estimateSize(cmd);
+    out.push_back(cmd);
+  }
+  XD("number of files = " << out.size());
+  return true;
+}
+
+// - Run -
+
+int SkDriver::run(const std::vector<Command> &commands, const Option &option, std::ostream &globalOut)
+{
+  if (commands.empty())
+    return 0;
+
+  bf::path tmpDir = bf::temp_directory_path() / bf::unique_path("skgen-%%%%-%%%%-%%%%");
+  bf::create_directories(tmpDir);
+  XD("temporary directory = " << tmpDir);
+
+  std::vector<bf::path> outPaths, globalPaths;
+  std::vector<size_t> pending; // indices of the commands, larger files first
+  for (size_t i = 0; i < commands.size(); i++) {
+    std::string id = boost::lexical_cast<std::string>(i);
+    outPaths.push_back(tmpDir / (id + ".sk"));
+    globalPaths.push_back(tmpDir / (id + ".global"));
+    pending.push_back(i);
+  }
+  std::stable_sort(pending.begin(), pending.end(), LargerCommand(commands));
+  std::reverse(pending.begin(), pending.end()); // pop from the back
+
+  int jobs = std::max(1, option.jobs);
+  int failed = 0;
+  boost::unordered_map<pid_t, size_t> running;
+  while (!pending.empty() || !running.empty()) {
+    while (!pending.empty() && (int)running.size() < jobs) {
+      size_t i = pending.back();
+      pending.pop_back();
+      XD("spawn: file = " << commands[i].file << ", size = " << commands[i].sizeEstimate);
+      pid_t pid = spawn(commands[i], option, outPaths[i], globalPaths[i]);
+      if (pid < 0) {
+        std::cerr << "skdriver:warning: failed to fork worker for " << commands[i].file << std::endl;
+        failed++;
+      } else
+        running[pid] = i;
+    }
+    if (running.empty())
+      continue;
+
+    int status;
+    pid_t pid = ::waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR)
+        continue;
+      std::perror("skdriver");
+      failed += running.size();
+      break;
+    }
+    boost::unordered_map<pid_t, size_t>::iterator p = running.find(pid);
+    if (p == running.end())
+      continue;
+    size_t i = p->second;
+    running.erase(p);
+    if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+      std::cerr << "skdriver:warning: failed to skeletonize " << commands[i].file << std::endl;
+      failed++;
+    }
+  }
+
+  // Merge in the order of the commands
+  for (size_t i = 0; i < commands.size(); i++) {
+    appendFile(std::cout, outPaths[i]);
+    appendFile(globalOut, globalPaths[i]);
+  }
+  std::cout.flush();
+
+  boost::system::error_code ec;
+  bf::remove_all(tmpDir, ec);
+  XD("exit: failed = " << failed);
+  return failed;
+}
+
+// EOF
@@ -0,0 +1,60 @@
+#ifndef SKDRIVER_H
+#define SKDRIVER_H
+
+// skdriver.h
+// 10/18/2026 jichi
+// Drive skgen over a whole project with multiple worker processes.
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ *  \brief  Project driver.
+ *
+ *  Each translation unit is skeletonized by a separate skgen process with its
+ *  own flags, so that the ROSE frontend could run in parallel. The outputs of
+ *  the workers are merged in the order of the translation units, independent
+ *  of the scheduling.
+ */
+namespace SkDriver {
+
+  ///  A translation unit to skeletonize.
+  struct Command {
+    std::string directory;              ///< working directory of the worker
+    std::string file;                   ///< source file, relative to directory
+    std::vector<std::string> arguments; ///< compiler flags without the compiler, -c, -o, and the source file
+    size_t sizeEstimate;                ///< used to schedule larger files first
+
+    Command() : sizeEstimate(0) {}
+  };
+
+  ///  Options of the driver.
+  struct Option {
+    std::string program;                ///< path to skgen
+    std::vector<std::string> arguments; ///< arguments passed to every worker before the compiler flags
+    int jobs;                           ///< number of worker processes
+
+    Option() : jobs(1) {}
+  };
+
+  ///  Append commands in a compile_commands.json to \p out. Return false if failed to parse.
+  bool loadCompileCommands(std::vector<Command> &out, const std::string &path);
+
+  ///  Append the source files listed one per line to \p out. Return false if failed to read.
+  bool loadFileList(std::vector<Command> &out, const std::string &path);
+
+  /**
+   *  \brief  Run the workers and wait until all of them finish.
+   *  \param  globalOut  receive the unknown parameters of all workers
+   *  \return  number of failed translation units
+   *
+   *  Larger files are scheduled first. The standard output of the workers is
+   *  forwarded, and the unknown parameters are written to \p globalOut, both
+   *  in the order of \p commands.
+   */
+  int run(const std::vector<Command> &commands, const Option &option, std::ostream &globalOut);
+
+} // namespace SkDriver
+
+#endif // SKDRIVER_H
@@ -9,9 +9,17 @@
 #include "sk/skquery.h"
 #include "rosex/dataflowtable.h"
 #include "rosex/tac.h"
+#include "rosex/approxdepgraph.h"
+#include "rosex/budget.h"
 #include "rosex/depgraph.h"
+#include "rosex/depslice.h"
 #include "rosex/defusegraph.h"
 #include "rosex/rosex.h"
+#include "rosex/slice_p.h"
+#include "skcache.h"
+#include "skdriver.h"
+#include "skprofiler.h"
+#include "skserver.h"
 
 //#include "opt/dep.h"
 //#include "opt/inline.h"
@@ -23,13 +31,24 @@
 #include <ExtractFunctionArguments.h>
 
 #include <boost/algorithm/string/predicate.hpp> // for boost::ends_with
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/date_time.hpp>
+#include <boost/thread.hpp>
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <map>
+#include <vector>
 #include <inttypes.h>
+#include <unistd.h>
 
 #define DEBUG "main"
 #include "xt/xdebug.h"
@@ -47,6 +66,17 @@
 
 #define GLOBAL_SKELETON "_global"
 
+#define CACHE_SIZE  256 // default cache size in MB
+
+#define SERVER_SOCKET ".skgen.sock"
+#define SERVER_REPARSES 16 // re-parsed files before the server restarts itself
+
+#define PROFILE_FILE  "skgen_profile.json"
+
+#define DEPGRAPH_SUFFIX ".depg"
+
+#define DEP_FAST_STATEMENTS 10000 // statements of a function to use the fast dependence engine
+
 namespace bf = boost::filesystem;
 
 namespace { // anonymous
@@ -55,6 +85,17 @@ namespace { // anonymous
   inline bool args_has_opt(char **begin, char **end, const std::string &option)
   { return std::find(begin, end, option) != end; }
 
+  // Return the value of the option in form of option=value, or the default value if not found.
+  inline std::string args_opt_value(char **begin, char **end, const std::string &option,
+                                    const std::string &defval = std::string())
+  {
+    const std::string prefix = option + "=";
+    for (char **p = begin; p != end; ++p)
+      if (boost::algorithm::starts_with(*p, prefix))
+        return *p + prefix.size();
+    return defval;
+  }
+
 //  inline std::string current_timestamp()
 //  {
 //#define STR(v)  boost::lexical_cast<std::string>(v)
@@ -158,6 +199,28 @@ namespace { // anonymous
     return false;
   }
 
+  ///  Number of statements in \p func, to choose the dependence engine.
+  size_t countStatements(SgNode *func)
+  { return NodeQuery::querySubTree(func, V_SgStatement).size(); }
+
+  ///  Open the global skeleton in append mode, and write the type sizes if it is new.
+  void openGlobalSkeleton(std::fstream &out, const std::string &path)
+  {
+    bool exists = bf::exists(path);
+    out.open(path.c_str(), std::fstream::out|std::fstream::app);
+    if (!exists)
+      out
+        << "// global\n"
+        << ": char = " << sizeof(char) << "\n"
+        << ": string = " << sizeof(char) << "\n"
+        << ": bool = " << sizeof(bool) << "\n"
+        << ": int = " << sizeof(int) << "\n"
+        << ": float = " << sizeof(float) << "\n"
+        << ": double = " << sizeof(double) << "\n"
+        << ": complex = " << 2*sizeof(double) << "\n"
+        ;
+  }
+
   void showHelp()
   {
     std::cout
@@ -172,7 +235,35 @@ namespace { // anonymous
       << " -sk:nodep                 Ignore data dependence\n"
       << " -sk:nodep:br              Ignore data dependence for branches\n"
       << " -sk:nodep:loop            Ignore data dependence for loops\n"
+      << " -sk:dep=full|fast         Dependence engine of all functions, where fast only uses def/use of named variables\n"
+      << " -sk:dep:fast=N            Use the fast engine for functions over N statements, default " << DEP_FAST_STATEMENTS << ", 0 for never\n"
+      << " -sk:dep:save=DIR          Save the dependence graph of each analyzed function into DIR\n"
+      << " -sk:dep:regions=N         Build dependence of top-level statements with N threads, 0 for all cores\n"
+      << " -sk:dep:memo              Reuse array dependence tests of identical subscript patterns\n"
+      << " -sk:dep:filter            Prove independence by name, GCD, and Banerjee tests before ROSE\n"
+      << " -sk:dep:filter:verify     Compare the filtered dependence tests with ROSE\n"
+      << " -sk:dep:exact             Compute exact dependence distances of affine array references\n"
+      << " -sk:dep:exact:verify      Compare the exact dependence tests with ROSE\n"
+      << " -sk:dep:demand            Only test array dependences that could reach the critical references\n"
+      << " -sk:dep:arena             Allocate dependence graph vertices and edges in per-graph blocks\n"
+      << " -sk:budget:time=SECONDS   Fall back to nodep:br and then nodep for functions analyzed longer\n"
+      << " -sk:budget:memory=MB      Fall back to nodep:br and then nodep for functions using more memory,\n"
+      << "                           ignored with -sk:jobs\n"
       << " -sk:nopurge               Do not remove skeleton-unsupported syntax\n"
+      << " -sk:jobs=N                Analyze N functions concurrently, 0 for all cores\n"
+      << " -sk:compdb=FILE           Skeletonize files in compile_commands.json with -sk:jobs processes\n"
+      << " -sk:filelist=FILE         Skeletonize files listed one per line with -sk:jobs processes\n"
+      << " -sk:global=FILE           Write unknown parameters to FILE instead of " GLOBAL_SKELETON ".sk\n"
+      << " -sk:cache=DIR             Reuse outputs of unchanged functions cached in DIR\n"
+      << " -sk:cache:size=MB         Limit the size of the cache, default " << CACHE_SIZE << "MB\n"
+      << " -sk:profile[=FILE]        Write phase timings and counters as JSON, default " PROFILE_FILE "\n"
+      << " -sk:socket=PATH           Socket of the server, default " SERVER_SOCKET "\n"
+      << " --serve                   Parse the files once, and serve requests on -sk:socket\n"
+      << " --request REQUEST ...     Send a request to the server, one of:\n"
+      << "                             file PATH [-sk:OPTIONS]\n"
+      << "                             function NAME [-sk:OPTIONS]\n"
+      << "                             reload\n"
+      << "                             quit\n"
       //<< " -sk:opt                   Optimize the source code, imply sk:unparse \n"
       //<< " -sk:sideeffect            Enable function side effect interface\n"
       << " -sk:unparse               Generate ROSE processed source code\n"
@@ -183,6 +274,929 @@ namespace { // anonymous
 
 } // anonymous namespace
 
+namespace { // anonymous, function analysis
+
+  ///  Command line options used to analyze each function
+  struct AnalysisOption
+  {
+    bool devec,     // !-sk:nodevec
+         defuse,    // -sk:defuse
+         dep,       // !-sk:nodep
+         depBranch, // !-sk:nodep:br
+         depLoop,   // !-sk:nodep:loop
+         depMemo,   // -sk:dep:memo
+         depFilter, // -sk:dep:filter
+         depVerify, // -sk:dep:filter:verify
+         depFast,   // -sk:dep=fast
+         depExact,  // -sk:dep:exact
+         depVerifyExact, // -sk:dep:exact:verify
+         depDemand, // -sk:dep:demand
+         depArena,  // -sk:dep:arena
+         profile;   // -sk:profile, set by generateFile
+    int depRegions; // -sk:dep:regions
+    int depFastStatements; // -sk:dep:fast
+    std::string depSave; // -sk:dep:save
+    double budgetSeconds; // -sk:budget:time
+    size_t budgetMegabytes; // -sk:budget:memory
+
+    AnalysisOption()
+      : devec(true), defuse(false), dep(true), depBranch(true), depLoop(true), depMemo(false),
+        depFilter(false), depVerify(false), depFast(false), depExact(false),
+        depVerifyExact(false), depDemand(false), depArena(false), profile(false),
+        depRegions(1), depFastStatements(DEP_FAST_STATEMENTS), budgetSeconds(0), budgetMegabytes(0) {}
+  };
+
+  ///  Degraded dependence analysis of a function over budget
+  enum DepFallback { NoFallback = 0, FallbackNoBranch, FallbackNoDep };
+
+  ///  Option equivalent to the fallback level.
+  const char *depFallbackName(DepFallback level)
+  {
+    switch (level) {
+    case FallbackNoBranch: return "nodep:br";
+    case FallbackNoDep: return "nodep";
+    default: return "dep";
+    }
+  }
+
+  ///  Return the file in \p dir to save the dependence graph of \p func.
+  std::string depGraphFile(const std::string &dir, SgFunctionDefinition *func)
+  {
+    std::string name = func->get_declaration()->get_mangled_name().getString();
+    foreach (char &ch, name)
+      if (!std::isalnum((unsigned char)ch) && ch != '_')
+        ch = '_';
+    return (bf::path(dir) / (name + DEPGRAPH_SUFFIX)).string();
+  }
+
+  /**
+   *  \brief  Build the skeleton of a function.
+   *
+   *  It could be invoked from any thread. The returned skeleton is numbered
+   *  using the counters of the current thread.
+   *
+   *  The analyses share the budget of -sk:budget:*. If the dependence graph
+   *  exceeds it, the function falls back to nodep:br using the fast engine
+   *  under a new budget, and then to nodep. The fast engine could not be
+   *  interrupted, and is only checked after slicing. If the def-use graph has
+   *  already exceeded the budget, nodep is used directly. The level and the reason
+   *  are returned in \p fallback, which is left empty otherwise.
+   */
+  SkNode *analyzeFunction(SgFunctionDefinition *func, const AnalysisOption &option,
+                          SkProfileRecord *profile = nullptr, std::string *fallback = nullptr)
+  {
+    AnalysisBudget budget(option.budgetSeconds, option.budgetMegabytes);
+    boost::unordered_map<SkSlice *, SkVariable *> slices;
+    SkBuilder::Option opt;
+    if (option.devec)
+      opt.danglingSlices = &slices;
+    // Compute the set of critical references
+
+    boost::unordered_map<const SgNode *, std::string> names; // AST node references we want to preserve
+#ifdef ENABLE_DEFUSEGRAPH
+    if (option.defuse) {
+      XD("!-sk:nodefuse  apply defuse analysis");
+      SkProfileTimer timer(profile, "defuse");
+      DefUseGraph g(func);
+      if (!g)
+        std::cerr << "Failed to build define-use chain graph." << std::endl;
+      else {
+        //g.dump(); // debug
+        //g.toDOT("test.dot");
+        boost::unordered_map<std::string, int> counts; // count of names
+        foreach (DefUseGraph::vertex_type v, g.rvertices()) // rvertices to invert the iteration order
+          if (v.type() == DefUseGraphVertex::def)
+            if (SgNode *var = v.reference())
+              if (!rosex::isArrayReference(var) && g.has_out_edges(v))
+                if (SgVariableSymbol *symbol = rosex::getVariableSymbol(var)) {
+                  std::string name = symbol->get_name().getString();
+                  //BOOST_AUTO(p, counts.find(name));
+                  //if (p == counts.end())
+                  if (!counts.count(name))
+                    counts[name] = 0;
+                  else {
+                    int count = ++counts[name];
+                    name.append(DEFUSE_DELIM);
+                    name.append(boost::lexical_cast<std::string>(count));
+                    names[var] = name;
+                    foreach (DefUseGraph::edge_type e, g.out_edges(v)) {
+                      DefUseGraph::vertex_type use = g.target(e);
+                      ROSE_ASSERT(use.type() == DefUseGraphVertex::use);
+                      names[use.reference()] = name;
+                    }
+                  }
+                }
+      }
+    }
+    XD("def use name size = " << names.size());
+    if (profile && option.defuse)
+      profile->addCount("defuse.names", names.size());
+    if (!names.empty())
+      opt.variableNames = &names;
+#endif // ENABLE_DEFUSEGRAPH
+
+    NodeIndex nodes; // dense numbering of the expressions and statements in the dependences
+    NodeBitSet refs(&nodes); // AST node references we want to preserve
+#ifdef ENABLE_DEPGRAPH
+    // Fallback ladder on overrun: full dependence, nodep:br with the fast engine, and nodep
+    bool depBranch = option.depBranch,
+         fast = option.dep && (option.depFast ||
+        (option.depFastStatements && countStatements(func) > (size_t)option.depFastStatements));
+    DepFallback level = NoFallback;
+    AnalysisBudget::Resource overrun = AnalysisBudget::None;
+    if (option.dep && budget.exceededNow()) { // by the def-use analysis
+      overrun = budget.resource();
+      level = FallbackNoDep;
+    }
+    boost::scoped_ptr<DepSlice> slicer;
+    boost::scoped_ptr<SkProfileTimer> closureTimer; // indexing and slicing
+    if (option.dep && !fast && !level) {
+      XD("!-sk:nodep  apply dependence analysis");
+      SkProfileTimer depTimer(profile, "depgraph");
+      DepGraphOption depOption;
+      depOption.regionThreads = option.depRegions;
+      depOption.memoTests = option.depMemo;
+      depOption.filterTests = option.depFilter;
+      depOption.verifyTests = option.depVerify;
+      depOption.exactTests = option.depExact;
+      depOption.verifyExactTests = option.depVerifyExact;
+      depOption.arena = option.depArena;
+      depOption.compactEdges = option.depSave.empty(); // the slice only needs the records
+      if (budget.limited())
+        depOption.budget = &budget;
+      if (option.depDemand)
+        depOption.demand = boost::bind(IsCriticalReference, _1, depBranch, option.depLoop);
+      bool hasOption = option.depRegions > 1 || option.depMemo || option.depFilter || option.depVerify ||
+                       option.depExact || option.depVerifyExact || depOption.budget || option.depDemand ||
+                       option.depArena || depOption.compactEdges;
+      DepGraph g(func, hasOption ? &depOption : nullptr);
+      depTimer.stop();
+
+      if (!g.valid()) {
+        if (budget.exceededNow()) {
+          overrun = budget.resource();
+          level = FallbackNoBranch;
+          fast = true;
+          depBranch = false;
+          budget.start(); // for the fast engine
+        } else
+          std::cerr << "main:warning: failed to create dependence graph for function" << std::endl;
+      } else {
+        XD("dep graph size = " << g.num_vertices());
+        if (!option.depSave.empty()) {
+          std::string path = depGraphFile(option.depSave, func);
+          if (!g.save(path))
+            std::cerr << "main:warning: failed to save dependence graph: " << path << std::endl;
+        }
+        if (profile) {
+          profile->addCount("dep.vertices", g.num_vertices());
+          profile->addCount("dep.edges", g.num_edges());
+          profile->addCount("dep.duplicates", g.num_duplicate_edges());
+          profile->addCount("dep.loops", g.num_loops());
+          profile->addCount("dep.loopEdges", g.num_loop_edges());
+          profile->addCount("dep.tests", g.num_array_tests());
+          profile->addCount("dep.alloc", g.num_allocations());
+          profile->addCount("dep.alloc.heap", g.num_heap_allocations());
+          profile->addCount("dep.alloc.bytes", g.allocated_bytes());
+          profile->addCount("dep.alloc.payloads", g.num_edge_payloads());
+          profile->addCount("dep.alloc.relations", g.num_edge_relations());
+          if (option.depMemo) {
+            profile->addCount("dep.tests.hits", g.num_cached_array_tests());
+            profile->addCount("dep.tests.uncached", g.num_uncacheable_array_tests());
+          }
+          if (option.depFilter || option.depVerify)
+            profile->addCount("dep.tests.filtered", g.num_filtered_array_tests());
+          if (option.depVerify)
+            profile->addCount("dep.tests.mismatches", g.num_mismatched_array_tests());
+          if (option.depExact || option.depVerifyExact)
+            profile->addCount("dep.tests.exact", g.num_exact_array_tests());
+          if (option.depVerifyExact)
+            profile->addCount("dep.tests.exact.mismatches", g.num_mismatched_exact_tests());
+          if (option.depDemand) {
+            profile->addCount("dep.tests.deferred", g.num_deferred_array_tests());
+            profile->addCount("dep.demand.pairs", g.num_demanded_pairs());
+          }
+          typedef DepGraph::snapshot_type::type_count_list::value_type type_count;
+          foreach (const type_count &p, g.edge_type_counts())
+            profile->addCount("dep.edges." + DepType2String(p.first), p.second);
+        }
+        g.compact(); // after saving the loop relations
+        closureTimer.reset(new SkProfileTimer(profile, "closure"));
+        slicer.reset(new DepSlice(g, &nodes));
+      }
+    }
+    if (fast && level != FallbackNoDep) {
+      XD("-sk:dep=fast  apply approximate dependence analysis");
+      SkProfileTimer depTimer(profile, "depgraph");
+      ApproxDepGraph g(func);
+      depTimer.stop();
+      if (profile) {
+        profile->addCount("dep.fast", 1);
+        profile->addCount("dep.edges", g.num_edges());
+        profile->addCount("dep.fast.references", g.statistics().references);
+        profile->addCount("dep.fast.groups", g.statistics().groups);
+      }
+      closureTimer.reset(new SkProfileTimer(profile, "closure"));
+      slicer.reset(new DepSlice(g, &nodes));
+    }
+    if (slicer) {
+      NodeBitSet stmts(&nodes); // critical statements
+      slicer->slice(refs, stmts, boost::bind(IsCriticalReference, _1, depBranch, option.depLoop));
+      closureTimer.reset();
+      if (profile) {
+        profile->addCount("closure.seeds", slicer->statistics().seeds);
+        profile->addCount("closure.visits", slicer->statistics().visits);
+        profile->addCount("critical.references", refs.count());
+        profile->addCount("critical.statements", stmts.count());
+      }
+      // The fast engine and the slice could not be interrupted, and are only checked afterwards
+      if (fast && budget.exceededNow()) {
+        if (overrun == AnalysisBudget::None)
+          overrun = budget.resource();
+        level = FallbackNoDep;
+        refs.clear();
+      }
+    }
+    if (level) {
+      const char *resource = AnalysisBudget::resourceName(overrun);
+      std::cerr << "main:warning: " << resource << " budget exceeded, fall back to " << depFallbackName(level)
+                << ": " << func->get_declaration()->get_name().getString() << std::endl;
+      if (profile) {
+        profile->addCount(std::string("budget.fallback.") + depFallbackName(level));
+        profile->addCount(std::string("budget.exceeded.") + resource);
+      }
+      if (fallback)
+        *fallback = std::string(depFallbackName(level)) + ", " + resource + " budget exceeded";
+    }
+
+    XD("dep ref size = " << refs.count());
+    //if (!refs.empty())
+    opt.criticalReferences = &refs;
+    opt.criticalIndex = &nodes;
+#endif // ENABLE_DEPGRAPH
+
+    SkProfileTimer buildTimer(profile, "fromFunction");
+    SkNode *k_func;
+    {
+      // SkBuilder calls the ROSE unparser and NodeQuery, which are not known to be thread-safe
+      boost::unique_lock<boost::shared_mutex> lock(slice::globalAnalysisMutex());
+      k_func = SkBuilder::fromFunction(func, &opt);
+    }
+    buildTimer.stop();
+    if (option.devec && SageInterface::is_Fortran_language()) {
+      SkProfileTimer timer(profile, "devectorize");
+      k_func = SkBuilder::devectorize(k_func);
+    }
+    return k_func;
+  }
+
+  ///  Skeleton of a function to be built by FunctionJobPool
+  struct FunctionJob
+  {
+    SgFunctionDefinition *func;
+    SkNode *skeleton;
+    SkBuilder::Counters counters; // counters consumed by the skeleton
+    SkProfileRecord profile;
+
+    std::string cacheKey;
+    SkCache::Entry cacheEntry;
+    bool cached; // skip analysis if cacheEntry is loaded
+    std::string fallback; // degraded analysis over budget, not cached
+
+    explicit FunctionJob(SgFunctionDefinition *f = nullptr)
+      : func(f), skeleton(nullptr),
+        profile(f ? f->get_declaration()->get_name().getString() : std::string()),
+        cached(false) {}
+  };
+
+  /**
+   *  \brief  Worker pool to build function skeletons concurrently.
+   *
+   *  Each skeleton is built from zero counters, and needs to be renumbered
+   *  with SkBuilder::renumber in source order before being unparsed.
+   *  So that the output is the same regardless of the number of threads.
+   *
+   *  The analyses run concurrently, while SkBuilder::fromFunction is
+   *  serialized by the unique lock of slice::globalAnalysisMutex(), as it
+   *  unparses and queries the ROSE AST.
+   */
+  class FunctionJobPool
+  {
+    std::vector<FunctionJob> &jobs_;
+    const AnalysisOption &option_;
+    boost::mutex mutex_;
+    size_t next_; // next job to take
+
+  public:
+    FunctionJobPool(std::vector<FunctionJob> &jobs, const AnalysisOption &option)
+      : jobs_(jobs), option_(option), next_(0) {}
+
+    ///  Block until all jobs are finished.
+    void run(int threadCount)
+    {
+      if (threadCount > (int)jobs_.size())
+        threadCount = jobs_.size();
+      if (threadCount <= 1)
+        work();
+      else {
+        boost::thread_group pool;
+        for (int i = 0; i < threadCount; i++)
+          pool.create_thread(boost::bind(&FunctionJobPool::work, this));
+        pool.join_all();
+      }
+    }
+
+  private:
+    FunctionJob *take()
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      return next_ < jobs_.size() ? &jobs_[next_++] : nullptr;
+    }
+
+    void work()
+    {
+      while (FunctionJob *job = take()) {
+        if (job->cached)
+          continue;
+        SkBuilder::Counters saved = SkBuilder::counters();
+        SkBuilder::setCounters(SkBuilder::Counters());
+        job->skeleton = analyzeFunction(job->func, option_, option_.profile ? &job->profile : nullptr,
+                                        &job->fallback);
+        job->counters = SkBuilder::counters();
+        SkBuilder::setCounters(saved);
+      }
+    }
+  };
+
+  // - Output -
+
+  ///  Command line options used to render each function
+  struct RenderOption
+  {
+    bool purge,     // !-sk:nopurge
+         dataflow,  // -sk:dataflow
+         tac;       // -sk:tac
+
+    RenderOption() : purge(true), dataflow(false), tac(false) {}
+  };
+
+  ///  Counters numbering the output, see SkCache::Counters.
+  SkCache::Counters outputCounters()
+  {
+    SkCache::Counters ret;
+    SkBuilder::Counters k = SkBuilder::counters();
+    ret.blockBarriers = k.blockBarriers;
+    ret.tempScalars = k.tempScalars;
+    ret.dataflowTemps = DataFlowTable::Reference::tempCount();
+    ret.tacTemps = TacTable::Reference::tempCount();
+    return ret;
+  }
+
+  void setOutputCounters(const SkCache::Counters &val)
+  {
+    SkBuilder::Counters k;
+    k.blockBarriers = val.blockBarriers;
+    k.tempScalars = val.tempScalars;
+    SkBuilder::setCounters(k);
+    DataFlowTable::Reference::setTempCount(val.dataflowTemps);
+    TacTable::Reference::setTempCount(val.tacTemps);
+  }
+
+  /**
+   *  \brief  Render the skeleton, dataflow, and TAC sections of a function.
+   *  \param  numbering  counters the skeleton is currently numbered from, updated to \p base
+   *  \return  sections with the dataflow and TAC counters consumed
+   */
+  SkCache::Entry renderFunction(SkNode *k_func, SkCache::Counters &numbering,
+                                const SkCache::Counters &base, const RenderOption &option,
+                                SkProfileRecord *profile = nullptr)
+  {
+    SkBuilder::Counters offset;
+    offset.blockBarriers = base.blockBarriers - numbering.blockBarriers;
+    offset.tempScalars = base.tempScalars - numbering.tempScalars;
+    SkBuilder::renumber(k_func, offset);
+    numbering = base;
+
+    SkCache::Entry ret;
+    {
+      SkProfileTimer timer(profile, "unparse");
+      ret.skeleton = k_func->unparse();
+    }
+    {
+      SkProfileTimer timer(profile, "indent");
+      ret.skeleton = SkBuilder::indent(ret.skeleton);
+    }
+    if (option.purge) {
+      SkProfileTimer timer(profile, "purge");
+      ret.skeleton = SkBuilder::purge(ret.skeleton);
+    }
+
+    if (option.dataflow) {
+      SkProfileTimer timer(profile, "dataflow");
+      DataFlowTable::Reference::setTempCount(base.dataflowTemps);
+      foreach (SkNode *node, SkQuery::find(k_func, Sk::C_BlockBarrier, Sk::PreOrder)) {
+        SkBlockBarrier *barrier = static_cast<SkBlockBarrier *>(node);
+        DataFlowTable dft;
+        dft.initWithStatements(barrier->sourceStatements());
+        ret.dataflow.append("// ").append(barrier->name()).append("\n")
+                    .append(dft.toString()).append("\n");
+      }
+      ret.counters.dataflowTemps = DataFlowTable::Reference::tempCount() - base.dataflowTemps;
+    }
+
+    if (option.tac) {
+      SkProfileTimer timer(profile, "tac");
+      TacTable::Reference::setTempCount(base.tacTemps);
+      foreach (SkNode *node, SkQuery::find(k_func, Sk::C_BlockBarrier, Sk::PreOrder)) {
+        SkBlockBarrier *barrier = static_cast<SkBlockBarrier *>(node);
+        TacTable tac;
+        std::string beg = "[" + boost::replace_first_copy(barrier->name(), " ", ":") + "]";
+        tac.initWithStatements(barrier->sourceStatements());
+        ret.tac.append(beg).append("\n")
+               .append(tac.toString()).append("\n");
+      }
+      ret.counters.tacTemps = TacTable::Reference::tempCount() - base.tacTemps;
+    }
+    return ret;
+  }
+
+  ///  Everything other than the function itself that affects its output, used in the cache key.
+  std::string cacheContext(SgFile *file, const std::string &options)
+  {
+    std::ostringstream out;
+    out << options << "\n";
+
+    const SkConf &conf = SkNode::configuration();
+    out << conf.k_functionDefinition << " " << conf.k_blockStatement << " "
+        << conf.k_loadStatement << " " << conf.k_storeStatement << " "
+        << conf.k_floatingPointStatement << " " << conf.k_fixedPointStatement << " "
+        << conf.k_allocateStatement << " " << conf.k_deallocateStatement << "\n";
+
+    // Global declarations such as variables and types, excluding other functions
+    if (SgSourceFile *src = isSgSourceFile(file))
+      if (SgGlobal *g = src->get_globalScope())
+        foreach (SgDeclarationStatement *decl, g->get_declarations()) {
+          SgFunctionDeclaration *f = isSgFunctionDeclaration(decl);
+          if (!f || !f->get_definition())
+            out << decl->unparseToString() << "\n";
+        }
+    return out.str();
+  }
+
+  // - Generation -
+
+  ///  Return the number of threads in -sk:jobs, or in \p opt.
+  int parseJobs(char **begin, char **end, const char *opt = "-sk:jobs")
+  {
+    int ret = 1;
+    try {
+      ret = boost::lexical_cast<int>(args_opt_value(begin, end, opt, "1"));
+    } catch (boost::bad_lexical_cast &) {
+      std::cerr << "main:warning: invalid " << opt << ", use 1 instead" << std::endl;
+    }
+    if (ret <= 0)
+      ret = std::max(1u, boost::thread::hardware_concurrency());
+    return ret;
+  }
+
+  ///  Options to generate the outputs of source files
+  struct GenerateOption
+  {
+    AnalysisOption analysis;
+    RenderOption render;
+    int jobs;
+    SkCache *cache;           // not owned, could be null
+    std::string cacheOptions; // options in the cache key
+    std::string function;     // only generate this function if not empty
+    SkProfiler *profiler;     // not owned, could be null
+
+    GenerateOption() : jobs(1), cache(nullptr), profiler(nullptr) {}
+  };
+
+  /**
+   *  Disable the memory budget if functions are analyzed concurrently.
+   *
+   *  The memory budget is the growth of the whole process, which would count
+   *  the other functions in flight, so that the function falling back would
+   *  depend on the scheduling rather than on its own analysis.
+   */
+  void checkMemoryBudget(GenerateOption &option)
+  {
+    if (option.jobs > 1 && option.analysis.budgetMegabytes) {
+      std::cerr << "main:warning: -sk:budget:memory ignored with -sk:jobs=" << option.jobs << std::endl;
+      option.analysis.budgetMegabytes = 0;
+    }
+  }
+
+  ///  Parse the -sk:* options except the cache.
+  GenerateOption parseGenerateOption(char **begin, char **end)
+  {
+    GenerateOption ret;
+    ret.jobs = parseJobs(begin, end);
+
+    ret.analysis.devec = !args_has_opt(begin, end, "-sk:nodevec");
+    ret.analysis.defuse = args_has_opt(begin, end, "-sk:defuse");
+    ret.analysis.dep = !args_has_opt(begin, end, "-sk:nodep");
+    ret.analysis.depBranch = !args_has_opt(begin, end, "-sk:nodep:br");
+    ret.analysis.depLoop = !args_has_opt(begin, end, "-sk:nodep:loop");
+    ret.analysis.depRegions = parseJobs(begin, end, "-sk:dep:regions");
+    ret.analysis.depMemo = args_has_opt(begin, end, "-sk:dep:memo");
+    ret.analysis.depFilter = args_has_opt(begin, end, "-sk:dep:filter");
+    ret.analysis.depVerify = args_has_opt(begin, end, "-sk:dep:filter:verify");
+    ret.analysis.depExact = args_has_opt(begin, end, "-sk:dep:exact");
+    ret.analysis.depVerifyExact = args_has_opt(begin, end, "-sk:dep:exact:verify");
+    ret.analysis.depDemand = args_has_opt(begin, end, "-sk:dep:demand");
+    ret.analysis.depArena = args_has_opt(begin, end, "-sk:dep:arena");
+    std::string fast = args_opt_value(begin, end, "-sk:dep:fast");
+    if (!fast.empty())
+      try {
+        ret.analysis.depFastStatements = std::max(0, boost::lexical_cast<int>(fast));
+      } catch (boost::bad_lexical_cast &) {
+        std::cerr << "main:warning: invalid -sk:dep:fast, use " << DEP_FAST_STATEMENTS << " instead" << std::endl;
+      }
+    std::string engine = args_opt_value(begin, end, "-sk:dep");
+    ret.analysis.depFast = engine == "fast";
+    if (engine == "full")
+      ret.analysis.depFastStatements = 0;
+    ret.analysis.depSave = args_opt_value(begin, end, "-sk:dep:save");
+    std::string seconds = args_opt_value(begin, end, "-sk:budget:time");
+    if (!seconds.empty())
+      try {
+        ret.analysis.budgetSeconds = std::max(0.0, boost::lexical_cast<double>(seconds));
+      } catch (boost::bad_lexical_cast &) {
+        std::cerr << "main:warning: invalid -sk:budget:time, ignored" << std::endl;
+      }
+    std::string megabytes = args_opt_value(begin, end, "-sk:budget:memory");
+    if (!megabytes.empty())
+      try {
+        ret.analysis.budgetMegabytes = std::max(0, boost::lexical_cast<int>(megabytes));
+      } catch (boost::bad_lexical_cast &) {
+        std::cerr << "main:warning: invalid -sk:budget:memory, ignored" << std::endl;
+      }
+    checkMemoryBudget(ret);
+    if (!ret.analysis.depSave.empty()) {
+      boost::system::error_code ec;
+      bf::create_directories(ret.analysis.depSave, ec);
+    }
+
+    ret.render.purge = !args_has_opt(begin, end, "-sk:purge");
+#ifdef ENABLE_DATAFLOW
+    ret.render.dataflow = args_has_opt(begin, end, "-sk:dataflow");
+#endif // ENABLE_DATAFLOW
+#ifdef ENABLE_TAC
+    ret.render.tac = args_has_opt(begin, end, "-sk:tac");
+#endif // ENABLE_TAC
+
+    std::ostringstream out;
+    out << "devec=" << ret.analysis.devec
+        << " defuse=" << ret.analysis.defuse
+        << " dep=" << ret.analysis.dep
+        << " dep:br=" << ret.analysis.depBranch
+        << " dep:loop=" << ret.analysis.depLoop
+        << " dep:fast=" << ret.analysis.depFast << "," << ret.analysis.depFastStatements
+        << " dep:exact=" << (ret.analysis.depExact || ret.analysis.depVerifyExact)
+        << " purge=" << ret.render.purge
+        << " dataflow=" << ret.render.dataflow
+        << " tac=" << ret.render.tac
+        << " fortran=" << SageInterface::is_Fortran_language();
+    ret.cacheOptions = out.str();
+    return ret;
+  }
+
+  ///  Outputs of a source file
+  struct FileOutput
+  {
+    std::string skeleton, // unknown parameters are not replaced
+                dataflow,
+                tac,
+                console;  // dataflow and TAC printed while generating
+  };
+
+  /**
+   *  \brief  Generate the outputs of functions in the file.
+   *  \return  number of functions generated
+   */
+  int generateFile(FileOutput &out, SgFile *file, const GenerateOption &option)
+  {
+    std::ostringstream skOut, dfOut, tacOut, console;
+    SkProfiler *profiler = option.profiler;
+    SkProfileRecord *fileProfile = profiler ? profiler->addFile(file->getFileName()) : nullptr;
+
+    if (option.function.empty()) {
+      SkProfileTimer timer(fileProfile, "fromGlobal");
+      const char *header = "from " GLOBAL_SKELETON " import *\n";
+      skOut << header << std::endl;
+      if (SkNode *g = SkBuilder::fromGlobal(file))
+         skOut << "// global\n"
+               << SkBuilder::indent(g->unparse()) << std::endl;
+    }
+
+    SkCache *cache = option.cache;
+    std::vector<FunctionJob> jobs;
+    std::string context = cache ? cacheContext(file, option.cacheOptions) : std::string();
+    foreach (SgNode *n, NodeQuery::querySubTree(file, V_SgFunctionDefinition)) {
+      FunctionJob job(isSgFunctionDefinition(n));
+      if (!option.function.empty() &&
+          option.function != job.func->get_declaration()->get_name().getString())
+        continue;
+      if (cache) {
+        SkProfileTimer timer(profiler ? &job.profile : nullptr, "cache");
+        job.cacheKey = context + job.func->get_declaration()->unparseToString();
+        job.cached = cache->find(job.cacheEntry, job.cacheKey);
+        if (profiler)
+          job.profile.addCount(job.cached ? "cache.hits" : "cache.misses");
+      }
+      jobs.push_back(job);
+    }
+    {
+      // Time of the slowest thread
+      SkProfileTimer timer(fileProfile, "analysis");
+      AnalysisOption analysis = option.analysis;
+      analysis.profile = profiler != nullptr;
+      FunctionJobPool(jobs, analysis).run(option.jobs);
+    }
+
+    foreach (FunctionJob &job, jobs) {
+      SgFunctionDefinition *func = job.func;
+      const std::string func_name = func->get_declaration()->get_name().getString();
+
+      // Render in the numbering of the main thread in source order
+      SkProfileRecord *profile = profiler ? &job.profile : nullptr;
+      SkNode *k_func = job.skeleton;
+      SkCache::Counters base = outputCounters();
+      SkCache::Entry output;
+      if (job.cached) {
+        XD("main: replay cached function: " << func_name);
+        output.skeleton = SkCache::fill(job.cacheEntry.skeleton, base);
+        output.dataflow = SkCache::fill(job.cacheEntry.dataflow, base);
+        output.tac = SkCache::fill(job.cacheEntry.tac, base);
+        base += job.cacheEntry.counters;
+        setOutputCounters(base);
+      } else if (k_func) {
+        SkCache::Counters numbering; // skeletons are built from zero counters
+        bool rendered = false;
+        if (cache && job.fallback.empty()) { // fallbacks depend on the load
+          // Render once from the sentinels, and fill the template from base as a cached function
+          SkCache::Entry sentinelOutput = renderFunction(k_func, numbering, SkCache::sentinels(),
+                                                         option.render, profile);
+          sentinelOutput.counters.blockBarriers = job.counters.blockBarriers;
+          sentinelOutput.counters.tempScalars = job.counters.tempScalars;
+
+          SkProfileTimer timer(profile, "cache");
+          SkCache::Entry entry;
+          if (cache->makeEntry(entry, sentinelOutput)) {
+            cache->insert(job.cacheKey, entry);
+            output.skeleton = SkCache::fill(entry.skeleton, base);
+            output.dataflow = SkCache::fill(entry.dataflow, base);
+            output.tac = SkCache::fill(entry.tac, base);
+            // The skeleton counters are added below as for any function analyzed
+            base.dataflowTemps += entry.counters.dataflowTemps;
+            base.tacTemps += entry.counters.tacTemps;
+            setOutputCounters(base);
+            rendered = true;
+          }
+        }
+        if (!rendered) // not cacheable, or rejected by makeTemplate
+          output = renderFunction(k_func, numbering, base, option.render, profile);
+      }
+      if (!job.cached) {
+        SkBuilder::Counters counters = SkBuilder::counters();
+        counters += job.counters;
+        SkBuilder::setCounters(counters);
+      }
+
+      if (!k_func && !job.cached)
+        std::cerr << "failed to analyze the source code" << std::endl;
+      else {
+        XD("main: write skeleton: " << func_name);
+        skOut << "// " << func_name << "()" << std::endl;
+        if (!job.fallback.empty())
+          skOut << "// fallback: " << job.fallback << std::endl;
+        skOut << output.skeleton << std::endl;
+
+        if (option.render.dataflow) {
+          XD("main: generating dataflow summary");
+          console << "// dataflow:\n" << std::endl
+                  << output.dataflow;
+          dfOut << "// def " << func_name << "()\n" << std::endl
+                << output.dataflow;
+        }
+
+        if (option.render.tac) {
+          XD("main: generating three-address-code summary");
+          console << "// dataflow:\n" << std::endl
+                  << output.tac;
+          tacOut << "// def " << func_name << "()\n" << std::endl
+                 << output.tac;
+        }
+      }
+
+#ifdef ENABLE_ASSEMBLY
+      if (SkFunctionDefinition *f = sknode_cast<SkFunctionDefinition*>(k_func))
+        if (SkNode *body = f->body())
+          if (SgNode *stmt = body->source())
+            std::cerr << "Assembly follows:" << std::endl
+                      << rosex::unparseToAssembly(stmt) << std::endl;
+#endif // ENABLE_ASSEMBLY
+      delete k_func;
+      if (profiler)
+        profiler->addFunction(job.profile);
+    }
+
+    out.skeleton = skOut.str();
+    out.dataflow = dfOut.str();
+    out.tac = tacOut.str();
+    out.console = console.str();
+    return jobs.size();
+  }
+
+  ///  Replace the unknown parameters in the skeleton with global variables written to gout.
+  void replaceUnknowns(std::string &sk, const std::string &srcFile, int &globalVarCount, std::ostream &gout)
+  {
+    std::string srcBaseName = bf::basename(srcFile);
+    //gout << "\n"
+    //     << "// " << func_name << "()\n"
+    //     << "\n";
+    std::string unknown = SK_UNKNOWN;
+    size_t pos = 0;
+    while ((pos = sk.find(unknown.c_str(), pos)) != std::string::npos) {
+      std::string var = "_" + srcBaseName + "_" + boost::lexical_cast<std::string>(++globalVarCount);
+      sk.replace(pos, unknown.size(), var);
+      gout << ": " << var << " = 100\n";
+    }
+  }
+
+  ///  Return if the file is a Fortran module to skip.
+  bool isModuleFile(const std::string &srcFile)
+  {
+    return SageInterface::is_Fortran_language() && (
+        boost::algorithm::ends_with(srcFile, "rmod") ||
+        boost::algorithm::ends_with(srcFile, "RMOD"));
+  }
+
+  // Normalize Fortran loops.
+  // For the purpose of ROSE implementation, such as dependence analysis and loop boundary checking
+  // Before loop normalization:
+  //   for (int i = 10; i < 100; i+= 10)
+  //     loop_body(i);
+  // After loop normalization:
+  //   for (int i_norm = 1; i_norm < 10; i_norm += 1)
+  //     loop_body(i_norm * 10);
+  void normalizeLoops(SgNode *root)
+  {
+    if (SageInterface::is_Fortran_language())
+      foreach (SgNode *it, NodeQuery::querySubTree(root, V_SgFortranDo))
+        SageInterface::doLoopNormalization(::isSgFortranDo(it));
+    //else
+    //  foreach (SgNode *it, NodeQuery::querySubTree(root, V_SgForStatement))
+    //    SageInterface::forLoopNormalization(::isSgForStatement(it));
+  }
+
+  // - Server -
+
+  /**
+   *  \brief  Handle requests of the skeleton server with the parsed project.
+   *
+   *  Requests:
+   *  - file PATH [OPTIONS]: outputs of the source file
+   *  - function NAME [OPTIONS]: outputs of the functions with the name
+   *  - reload: re-parse the changed source files
+   *  - quit: stop the server
+   *
+   *  OPTIONS are -sk:* options replacing the ones of the server. Changed source
+   *  files are re-parsed before each request. Names are numbered from zero in
+   *  each response, as in a new process.
+   *
+   *  The AST of a re-parsed file is not released, as ROSE shares types and
+   *  symbols between files, and could not delete a file safely. The service
+   *  instead stops after SERVER_REPARSES re-parses with restart() set, and
+   *  the server re-executes itself to parse the project from scratch, so that
+   *  the memory of a long-lived server is bounded.
+   */
+  class SkeletonService
+  {
+    SgProject *project_;
+    SkCache *cache_;
+    int jobs_;
+    int reparses_; // files re-parsed since start
+    std::map<std::string, std::time_t> times_; // last write time of the parsed files
+
+  public:
+    SkeletonService(SgProject *project, SkCache *cache, int jobs)
+      : project_(project), cache_(cache), jobs_(jobs), reparses_(0)
+    {
+      foreach (SgFile *file, project_->get_fileList()) {
+        boost::system::error_code ec;
+        times_[file->getFileName()] = bf::last_write_time(file->getFileName(), ec);
+      }
+    }
+
+    bool operator()(const std::string &request, std::string &response)
+    {
+      std::vector<std::string> args;
+      std::istringstream in(request);
+      for (std::string arg; in >> arg;)
+        args.push_back(arg);
+      if (args.empty()) {
+        response = "error: empty request\n";
+        return true;
+      }
+
+      const std::string &cmd = args[0];
+      if (cmd == "quit") {
+        response = "ok\n";
+        return false;
+      }
+      refresh();
+      if (cmd == "reload") {
+        response = "ok\n";
+        return !restart();
+      }
+      if ((cmd != "file" && cmd != "function") || args.size() < 2) {
+        response = "error: invalid request: " + request + "\n";
+        return true;
+      }
+
+      std::vector<char *> argv;
+      for (size_t i = 2; i < args.size(); i++)
+        argv.push_back(const_cast<char *>(args[i].c_str()));
+      GenerateOption option = parseGenerateOption(argv.empty() ? nullptr : &argv[0],
+                                                  argv.empty() ? nullptr : &argv[0] + argv.size());
+      option.jobs = jobs_;
+      checkMemoryBudget(option);
+      option.cache = cache_;
+      if (cmd == "function")
+        option.function = args[1];
+
+      setOutputCounters(SkCache::Counters());
+      int globalVarCount = 0;
+      std::ostringstream out, gout;
+      bool found = false;
+      foreach (SgFile *file, project_->get_fileList()) {
+        const std::string srcFile = file->getFileName();
+        if (isModuleFile(srcFile))
+          continue;
+        if (cmd == "file") {
+          boost::system::error_code ec;
+          if (!bf::equivalent(srcFile, args[1], ec))
+            continue;
+        }
+        FileOutput output;
+        if (generateFile(output, file, option) || cmd == "file") {
+          found = true;
+          replaceUnknowns(output.skeleton, srcFile, globalVarCount, gout);
+          out << output.skeleton << output.dataflow << output.tac;
+        }
+      }
+
+      if (!found)
+        response = "error: not found: " + args[1] + "\n";
+      else {
+        response = out.str();
+        if (globalVarCount)
+          response.append("// " GLOBAL_SKELETON "\n").append(gout.str());
+      }
+      return !restart();
+    }
+
+    ///  If the server should restart to release the ASTs of the re-parsed files.
+    bool restart() const { return reparses_ >= SERVER_REPARSES; }
+
+  private:
+    ///  Re-parse the source files modified since the last parse.
+    void refresh()
+    {
+      SgFilePtrList &files = project_->get_fileList_ptr()->get_listOfFiles();
+      for (size_t i = 0; i < files.size(); i++) {
+        const std::string srcFile = files[i]->getFileName();
+        boost::system::error_code ec;
+        std::time_t t = bf::last_write_time(srcFile, ec);
+        if (ec || t == times_[srcFile])
+          continue;
+        XD("re-parse file: " << srcFile);
+        SgFile *file = nullptr;
+        try {
+          file = SageBuilder::buildFile(srcFile, std::string(), project_);
+        } catch (std::exception &e) {
+          XD("exception: " << e.what());
+        }
+        if (!file) {
+          std::cerr << "main:warning: failed to re-parse file: " << srcFile << std::endl;
+          continue;
+        }
+        // The new file is appended to the project, move it to the place of the old one.
+        // The AST of the old file is released by restart() instead.
+        files.erase(std::remove(files.begin(), files.end(), file), files.end());
+        files[i] = file;
+        normalizeLoops(file);
+        times_[srcFile] = t;
+        reparses_++;
+      }
+    }
+  };
+
+} // anonymous namespace
+
 int main(int argc, char *argv[])
 {
   bool opt_help = args_has_opt(argv, argv + argc, "--help") ||
@@ -195,11 +1209,79 @@ int main(int argc, char *argv[])
 
   XD("enter: argc = " << argc);
 
+  int opt_jobs = parseJobs(argv, argv + argc);
+
+  std::string opt_compdb = args_opt_value(argv, argv + argc, "-sk:compdb"),
+              opt_filelist = args_opt_value(argv, argv + argc, "-sk:filelist");
+  if (!opt_compdb.empty() || !opt_filelist.empty()) {
+    XD("-sk:compdb/-sk:filelist  run project driver: jobs = " << opt_jobs);
+    std::vector<SkDriver::Command> commands;
+    if (!opt_compdb.empty() && !SkDriver::loadCompileCommands(commands, opt_compdb) ||
+        !opt_filelist.empty() && !SkDriver::loadFileList(commands, opt_filelist)) {
+      XD("exit: failed to load project");
+      return -1;
+    }
+
+    SkDriver::Option driverOption;
+    driverOption.jobs = opt_jobs;
+    // Workers run in the directories of the compile commands
+    driverOption.program = ::strchr(argv[0], '/') ? bf::system_complete(argv[0]).string() : argv[0];
+    for (char **p = argv + 1; p != argv + argc; ++p)
+      if (!boost::algorithm::starts_with(*p, "-sk:compdb=") &&
+          !boost::algorithm::starts_with(*p, "-sk:filelist=") &&
+          !boost::algorithm::starts_with(*p, "-sk:global=") &&
+          !boost::algorithm::starts_with(*p, "-sk:jobs=") &&
+          !boost::algorithm::starts_with(*p, "-sk:profile")) // workers would overwrite each other
+        driverOption.arguments.push_back(*p);
+
+    std::fstream gout;
+    openGlobalSkeleton(gout, GLOBAL_SKELETON ".sk");
+    int failed = SkDriver::run(commands, driverOption, gout);
+    XD("exit: failed files = " << failed);
+    return failed ? -1 : 0;
+  }
+
+  std::string opt_socket = args_opt_value(argv, argv + argc, "-sk:socket", SERVER_SOCKET);
+  char **opt_request = std::find(argv, argv + argc, std::string("--request"));
+  if (opt_request != argv + argc) {
+    XD("--request  send request to " << opt_socket);
+    std::string request, response;
+    for (char **p = opt_request + 1; p != argv + argc; ++p)
+      request.append(p == opt_request + 1 ? "" : " ").append(*p);
+    if (!SkServer::request(response, opt_socket, request)) {
+      XD("exit: failed to connect");
+      return -1;
+    }
+    std::cout << response;
+    return 0;
+  }
+
+  // ROSE does not know --serve
+  bool opt_serve = false;
+  std::vector<char *> args;
+  for (char **p = argv; p != argv + argc; ++p)
+    if (::strcmp(*p, "--serve"))
+      args.push_back(*p);
+    else
+      opt_serve = true;
+  args.push_back(nullptr);
+
+  boost::scoped_ptr<SkProfiler> profiler;
+  std::string opt_profile = args_opt_value(argv, argv + argc, "-sk:profile");
+  if (!opt_profile.empty() || args_has_opt(argv, argv + argc, "-sk:profile")) {
+    if (opt_profile.empty())
+      opt_profile = PROFILE_FILE;
+    XD("-sk:profile  write profile to " << opt_profile);
+    profiler.reset(new SkProfiler);
+  }
+  SkProfileRecord *projectProfile = profiler ? profiler->project() : nullptr;
+
   XD("parsing project");
   SgProject *project;
   try {
     // Initialize the ROSE frontend
-    project = frontend(argc, argv);
+    SkProfileTimer timer(projectProfile, "frontend");
+    project = frontend(args.size() - 1, &args[0]);
   } catch (std::exception &e) {
     XD("exception: " << e.what());
     XD("exit: failed to parse project");
@@ -220,44 +1302,43 @@ int main(int argc, char *argv[])
   if (bf::exists(confPath))
     SkNode::setConfiguration(SkConf::fromFile(confPath.string()));
 
-  // Normalize Fortran loops.
-  // For the purpose of ROSE implementation, such as dependence analysis and loop boundary checking
-  // Before loop normalization:
-  //   for (int i = 10; i < 100; i+= 10)
-  //     loop_body(i);
-  // After loop normalization:
-  //   for (int i_norm = 1; i_norm < 10; i_norm += 1)
-  //     loop_body(i_norm * 10);
   XD("normalizing loops");
-  if (SageInterface::is_Fortran_language())
-    foreach (SgNode *it, NodeQuery::querySubTree(project, V_SgFortranDo))
-      SageInterface::doLoopNormalization(::isSgFortranDo(it));
-  //else
-  //  foreach (SgNode *it, NodeQuery::querySubTree(project, V_SgForStatement))
-  //    SageInterface::forLoopNormalization(::isSgForStatement(it));
+  {
+    SkProfileTimer timer(projectProfile, "doLoopNormalization");
+    normalizeLoops(project);
+  }
   XD("normalization finished");
 
-  bool opt_dataflow = args_has_opt(argv, argv + argc, "-sk:dataflow"),
-       opt_tac = args_has_opt(argv, argv + argc, "-sk:tac"),
-       opt_devec = !args_has_opt(argv, argv + argc, "-sk:nodevec"),
-       opt_purge = !args_has_opt(argv, argv + argc, "-sk:purge"),
-       opt_unparse = args_has_opt(argv, argv + argc, "-sk:unparse");
+  GenerateOption option = parseGenerateOption(argv, argv + argc);
+  option.profiler = profiler.get();
+  bool opt_unparse = args_has_opt(argv, argv + argc, "-sk:unparse");
        //opt_optimize = args_has_opt(argv, argv + argc, "-sk:opt");
   //bool opt_cov = args_has_opt(argv, argv + argc, "-sk:cov");
 
-#ifndef ENABLE_DATAFLOW
-  opt_dataflow = false;
-#endif // !ENABLE_DATAFLOW
-#ifndef ENABLE_TAC
-  opt_tac = false;
-#endif // !ENABLE_TAC
+  boost::scoped_ptr<SkCache> cache;
+  std::string opt_cache = args_opt_value(argv, argv + argc, "-sk:cache");
+  if (!opt_cache.empty()) {
+    int size = CACHE_SIZE;
+    std::string opt_size = args_opt_value(argv, argv + argc, "-sk:cache:size");
+    if (!opt_size.empty())
+      try {
+        size = boost::lexical_cast<int>(opt_size);
+      } catch (boost::bad_lexical_cast &) {
+        std::cerr << "main:warning: invalid -sk:cache:size, use " << size << " instead" << std::endl;
+      }
+    XD("-sk:cache  cache function outputs in " << opt_cache << ", size = " << size << "MB");
+    cache.reset(new SkCache(opt_cache, boost::uintmax_t(size) << 20));
+    option.cache = cache.get();
+  }
 
-  if (opt_dataflow)
+  if (option.render.dataflow)
     XD("-sk:dataflow  enable dataflow analysis");
-  if (opt_tac)
+  if (option.render.tac)
     XD("-sk:tac  generate three address code");
-  if (opt_devec)
+  if (option.analysis.devec)
     XD("!-sk:nodevec  convert vectorization to explicit loops");
+  if (option.jobs > 1)
+    XD("-sk:jobs  analyze functions with threads = " << option.jobs);
   //if (opt_optimize) {
   //  XD("!-sk:optimize  apply optimization");
   //  opt_unparse = true;
@@ -265,6 +1346,30 @@ int main(int argc, char *argv[])
   //if (opt_cov)
   //  XD("-sk:cov  generate coverage hints for branches");
 
+  if (opt_serve) {
+    XD("--serve  listen on " << opt_socket);
+    // Requests are not profiled
+    SkeletonService service(project, cache.get(), option.jobs);
+    bool ok = SkServer::serve(opt_socket, boost::ref(service));
+    if (cache) {
+      cache->prune();
+      std::cerr << "skcache: " << cache->statisticsString() << std::endl;
+    }
+    if (projectProfile)
+      projectProfile->addCount("memory.peak", AnalysisBudget::peakMemory() >> 10); // KB
+    if (profiler && !profiler->writeJson(opt_profile))
+      std::cerr << "main:warning: failed to write profile: " << opt_profile << std::endl;
+    if (ok && service.restart()) {
+      XD("restart: re-parsed files = " << SERVER_REPARSES);
+      std::cerr << "skserver: restart to release re-parsed files" << std::endl;
+      ::execvp(argv[0], argv);
+      std::perror(argv[0]);
+      return -1;
+    }
+    XD("exit: ok = " << ok);
+    return ok ? 0 : -1;
+  }
+
   //if (opt_optimize) {
   //  XD("optimizing applications");
   //  if (SgNode *src = rosex::findMainFunction(project)) {
@@ -295,29 +1400,23 @@ int main(int argc, char *argv[])
   //}
 
   XD("create global skeleton");
-  bool globalExists = bf::exists(GLOBAL_SKELETON ".sk");
-  std::fstream gout(GLOBAL_SKELETON ".sk", std::fstream::out|std::fstream::app);
-  if (!globalExists)
-    gout
-      << "// global\n"
-      << ": char = " << sizeof(char) << "\n"
-      << ": string = " << sizeof(char) << "\n"
-      << ": bool = " << sizeof(bool) << "\n"
-      << ": int = " << sizeof(int) << "\n"
-      << ": float = " << sizeof(float) << "\n"
-      << ": double = " << sizeof(double) << "\n"
-      << ": complex = " << 2*sizeof(double) << "\n"
-      ;
+  std::fstream gout;
+  std::string opt_global = args_opt_value(argv, argv + argc, "-sk:global");
+  if (opt_global.empty())
+    openGlobalSkeleton(gout, GLOBAL_SKELETON ".sk");
+  else {
+    // Unknown parameters only, to be merged by the project driver
+    XD("-sk:global  write unknown parameters to " << opt_global);
+    gout.open(opt_global.c_str(), std::fstream::out|std::fstream::trunc);
+  }
 
   XD("analyzing functions");
   foreach (SgFile *file, project->get_fileList()) {
     const std::string srcFile = file->getFileName();
-    if (SageInterface::is_Fortran_language())
-      if (boost::algorithm::ends_with(srcFile, "rmod") ||
-          boost::algorithm::ends_with(srcFile, "RMOD")) {
-        XD("skip module file: " << srcFile);
-        continue;
-      }
+    if (isModuleFile(srcFile)) {
+      XD("skip module file: " << srcFile);
+      continue;
+    }
 
     XD("process file: " << srcFile);
 
@@ -330,226 +1429,41 @@ int main(int argc, char *argv[])
     bf::path skPath = bf::change_extension(srcPath, ".sk");
     std::string skFile = skPath.string();
 
-    //std::ofstream skOut(skFile.c_str());
-
-    std::ofstream dfOut;
-    std::ofstream tacOut;
-    std::ostringstream skOut;
-
-    if (opt_dataflow)
-      dfOut.open(dfFile.c_str());
-
-    if (opt_tac)
-      tacOut.open(tacFile.c_str());
-
-    const char *header = "from " GLOBAL_SKELETON " import *\n";
-    skOut << header << std::endl;
-    if (SkNode *g = SkBuilder::fromGlobal(file))
-       skOut << "// global\n"
-             << SkBuilder::indent(g->unparse()) << std::endl;
-
-    foreach (SgNode *n, NodeQuery::querySubTree(file, V_SgFunctionDefinition)) {
-      SgFunctionDefinition *func = isSgFunctionDefinition(n);
-      const std::string func_name = func->get_declaration()->get_name().getString();
-
-      boost::unordered_map<SkSlice *, SkVariable *> slices;
-      SkBuilder::Option opt;
-      if (opt_devec)
-        opt.danglingSlices = &slices;
-      // Compute the set of critical references
-
-      boost::unordered_map<const SgNode *, std::string> names; // AST node references we want to preserve
-#ifdef ENABLE_DEFUSEGRAPH
-      bool opt_defuse = args_has_opt(argv, argv + argc, "-sk:defuse");
-      if (opt_defuse) {
-        XD("!-sk:nodefuse  apply defuse analysis");
-        DefUseGraph g(func);
-        if (!g)
-          std::cerr << "Failed to build define-use chain graph." << std::endl;
-        else {
-          //g.dump(); // debug
-          //g.toDOT("test.dot");
-          boost::unordered_map<std::string, int> counts; // count of names
-          foreach (DefUseGraph::vertex_type v, g.rvertices()) // rvertices to invert the iteration order
-            if (v.type() == DefUseGraphVertex::def)
-              if (SgNode *var = v.reference())
-                if (!rosex::isArrayReference(var) && g.has_out_edges(v))
-                  if (SgVariableSymbol *symbol = rosex::getVariableSymbol(var)) {
-                    std::string name = symbol->get_name().getString();
-                    //BOOST_AUTO(p, counts.find(name));
-                    //if (p == counts.end())
-                    if (!counts.count(name))
-                      counts[name] = 0;
-                    else {
-                      int count = ++counts[name];
-                      name.append(DEFUSE_DELIM);
-                      name.append(boost::lexical_cast<std::string>(count));
-                      names[var] = name;
-                      foreach (DefUseGraph::edge_type e, g.out_edges(v)) {
-                        DefUseGraph::vertex_type use = g.target(e);
-                        ROSE_ASSERT(use.type() == DefUseGraphVertex::use);
-                        names[use.reference()] = name;
-                      }
-                    }
-                  }
-        }
-      }
-      XD("def use name size = " << names.size());
-      if (!names.empty())
-        opt.variableNames = &names;
-#endif // ENABLE_DEFUSEGRAPH
-
-      boost::unordered_set<const SgNode *> refs; // AST node references we want to preserve
-#ifdef ENABLE_DEPGRAPH
-      bool opt_dep = !args_has_opt(argv, argv + argc, "-sk:nodep");
-      if (opt_dep) {
-        XD("!-sk:nodep  apply dependence analysis");
-        bool opt_dep_branch = !args_has_opt(argv, argv + argc, "-sk:nodep:br"),
-             opt_dep_loop = !args_has_opt(argv, argv + argc, "-sk:nodep:loop");
-        DepGraph g(func);
-
-        if (!g.valid())
-          std::cerr << "main:warning: failed to create dependence graph for function" << std::endl;
-        else {
-          XD("dep graph size = " << g.num_vertices());
-          size_t refs_size;
-          boost::unordered_set<const SgNode *> stmts; // critical statements
-          do {
-            refs_size = refs.size();
-            foreach (DepGraph::edge_type e, g.edges()) {
-              if (e.sourceExpression() && e.targetExpression() && (
-                    refs.count(e.targetExpression()) ||
-                    stmts.count(g.target(e).statement()) ||
-                    IsCriticalReference(e.targetExpression(), opt_dep_branch, opt_dep_loop))) {
-                refs.insert(e.sourceExpression());
-                stmts.insert(g.source(e).statement());
-              }
-            }
-          } while(refs_size != refs.size());
-        }
-      }
-
-      XD("dep ref size = " << refs.size());
-      //if (!refs.empty())
-      opt.criticalReferences = &refs;
-#endif // ENABLE_DEPGRAPH
-
-//#ifdef ENABLE_SIDEEFFECT
-#if 0
-      bool opt_sideeffect = args_has_opt(argv, argv + argc, "-sk:sideffect");
-      //opt_sideeffect = true;
-      if (opt_sideeffect) {
-        XD("-sk:sideeffect  apply function side effect analysis");
-        DepGraphOption opt;
-        FunctionSideEffectAnnotation funcInfo;
-        opt.funcInfo = &funcInfo;
-        DepGraph g(func, &opt);
-
-        if (!g.valid())
-          std::cerr << "main:warning: failed to create dependence graph for function" << std::endl;
-        else {
-          XD("dep graph size = " << g.num_vertices());
-          g.dump();
-          //size_t refs_size;
-          //boost::unordered_set<const SgNode *> stmts; // critical statements
-          //do {
-          //  refs_size = refs.size();
-          //  foreach (DepGraph::edge_type e, g.edges()) {
-          //    if (e.sourceExpression() && e.targetExpression() && (
-          //          refs.count(e.targetExpression()) ||
-          //          stmts.count(g.target(e).statement()) ||
-          //          IsCriticalReference(e.targetExpression(), opt_dep_branch, opt_dep_loop))) {
-          //      refs.insert(e.sourceExpression());
-          //      stmts.insert(g.source(e).statement());
-          //    }
-          //  }
-          //} while(refs_size != refs.size());
-        }
-      }
-      XD("dep ref size = " << refs.size());
-#endif // ENABLE_SIDEEFFECT
-
-      SkNode *k_func = SkBuilder::fromFunction(func, &opt);
-      if (opt_devec && SageInterface::is_Fortran_language())
-        k_func = SkBuilder::devectorize(k_func);
-      if (!k_func)
-        std::cerr << "failed to analyze the source code" << std::endl;
-      else {
-        XD("main: write skeleton to file: " << skFile);
-        std::string sk = k_func->unparse();
-        sk = SkBuilder::indent(sk);
-        if (opt_purge)
-          sk = SkBuilder::purge(sk);
-        skOut << "// " << func_name << "()" << std::endl
-              << sk << std::endl;
-
-        if (opt_dataflow) {
-          XD("main: generating dataflow summary");
-          XD("main: write dataflow to file: " << dfFile);
-
-          std::cout << "// dataflow:\n" << std::endl;
-          dfOut << "// def " << func_name << "()\n" << std::endl;
-          foreach (SkNode *node, SkQuery::find(k_func, Sk::C_BlockBarrier, Sk::PreOrder)) {
-            SkBlockBarrier *barrier = static_cast<SkBlockBarrier *>(node);
-            DataFlowTable dft;
-            dft.initWithStatements(barrier->sourceStatements());
-            std::cout << "// " << barrier->name() << std::endl
-                      << dft.toString() << std::endl;
-
-            dfOut << "// " << barrier->name() << "\n"
-                   << dft.toString() << std::endl;
-          }
-        }
+    FileOutput output;
+    generateFile(output, file, option);
 
-        if (opt_tac) {
-          XD("main: generating three-address-code summary");
-          XD("main: write tac to file: " << tacFile);
-          std::cout << "// dataflow:\n" << std::endl;
-          tacOut << "// def " << func_name << "()\n" << std::endl;
-          foreach (SkNode *node, SkQuery::find(k_func, Sk::C_BlockBarrier, Sk::PreOrder)) {
-            SkBlockBarrier *barrier = static_cast<SkBlockBarrier *>(node);
-            TacTable tac;
-            std::string beg = "[" + boost::replace_first_copy(barrier->name(), " ", ":") + "]";
-            tac.initWithStatements(barrier->sourceStatements());
-            std::cout << beg << "\n"
-                      << tac.toString() << std::endl;
-
-            tacOut << beg << "\n"
-                   << tac.toString() << std::endl;
-          }
-        }
-      }
+    if (option.render.dataflow) {
+      XD("main: write dataflow to file: " << dfFile);
+      std::ofstream dfOut(dfFile.c_str());
+      dfOut << output.dataflow;
+    }
 
-#ifdef ENABLE_ASSEMBLY
-      if (SkFunctionDefinition *f = sknode_cast<SkFunctionDefinition*>(k_func))
-        if (SkNode *body = f->body())
-          if (SgNode *stmt = body->source())
-            std::cerr << "Assembly follows:" << std::endl
-                      << rosex::unparseToAssembly(stmt) << std::endl;
-#endif // ENABLE_ASSEMBLY
-      delete k_func;
+    if (option.render.tac) {
+      XD("main: write tac to file: " << tacFile);
+      std::ofstream tacOut(tacFile.c_str());
+      tacOut << output.tac;
     }
 
     XD("output skeleton");
-    std::string sk = skOut.str();
-    {
-      std::string srcBaseName = bf::basename(srcFile);
-      //gout << "\n"
-      //     << "// " << func_name << "()\n"
-      //     << "\n";
-      std::string unknown = SK_UNKNOWN;
-      size_t pos = 0;
-      while ((pos = sk.find(unknown.c_str(), pos)) != std::string::npos) {
-        std::string var = "_" + srcBaseName + "_" + boost::lexical_cast<std::string>(++globalVarCount);
-        sk.replace(pos, unknown.size(), var);
-        gout << ": " << var << " = 100\n";
-      }
-    }
+    std::cout << output.console;
+    std::string sk = output.skeleton;
+    replaceUnknowns(sk, srcFile, globalVarCount, gout);
     std::cout << sk;
+    XD("main: write skeleton to file: " << skFile);
     std::ofstream f(skFile.c_str()); f << sk;
   }
   XD("traversal finished");
 
+  if (cache) {
+    cache->prune();
+    std::cerr << "skcache: " << cache->statisticsString() << std::endl;
+  }
+
+  if (projectProfile)
+    projectProfile->addCount("memory.peak", AnalysisBudget::peakMemory() >> 10); // KB
+  if (profiler && !profiler->writeJson(opt_profile))
+    std::cerr << "main:warning: failed to write profile: " << opt_profile << std::endl;
+
   //backend(project);
 
   // Output preprocessed source file.
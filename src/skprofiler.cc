@@ -0,0 +1,195 @@
+// skprofiler.cc
+// 10/18/2026 jichi
+
+#include "skprofiler.h"
+#include <boost/foreach.hpp>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/time.h>
+
+#define foreach BOOST_FOREACH
+
+namespace { // anonymous
+
+  double wallTime()
+  {
+    timeval tv;
+    ::gettimeofday(&tv, nullptr);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+  }
+
+  ///  CPU time of the calling thread, or of the process if not supported.
+  double cpuTime()
+  {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts;
+    if (!::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif // CLOCK_THREAD_CPUTIME_ID
+    return double(std::clock()) / CLOCKS_PER_SEC;
+  }
+
+  std::string jsonString(const std::string &s)
+  {
+    std::ostringstream out;
+    out << '"';
+    foreach (char ch, s)
+      switch (ch) {
+      case '"':  out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      case '\n': out << "\\n"; break;
+      case '\t': out << "\\t"; break;
+      default:
+        if ((unsigned char)ch < 0x20)
+          out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(ch) << std::dec;
+        else
+          out << ch;
+      }
+    out << '"';
+    return out.str();
+  }
+
+  template <typename L>
+  typename L::value_type::second_type &findOrAppend(L &l, const std::string &key)
+  {
+    for (typename L::iterator p = l.begin(); p != l.end(); ++p)
+      if (p->first == key)
+        return p->second;
+    l.push_back(typename L::value_type(key, typename L::value_type::second_type()));
+    return l.back().second;
+  }
+
+} // anonymous namespace
+
+// - Record -
+
+void SkProfileRecord::addPhase(const std::string &phase, double wall, double cpu, size_t calls)
+{
+  SkProfilePhase &p = findOrAppend(phases_, phase);
+  p.wall += wall;
+  p.cpu += cpu;
+  p.calls += calls;
+}
+
+void SkProfileRecord::addCount(const std::string &counter, long long n)
+{ findOrAppend(counters_, counter) += n; }
+
+void SkProfileRecord::merge(const Self &that)
+{
+  foreach (const PhaseList::value_type &p, that.phases_)
+    addPhase(p.first, p.second.wall, p.second.cpu, p.second.calls);
+  foreach (const CounterList::value_type &p, that.counters_)
+    addCount(p.first, p.second);
+}
+
+void SkProfileRecord::writeJsonMembers(std::ostream &out, const std::string &indent) const
+{
+  out << indent << "\"phases\": {";
+  for (size_t i = 0; i < phases_.size(); i++) {
+    const SkProfilePhase &p = phases_[i].second;
+    out << (i ? "," : "") << "\n"
+        << indent << "  " << jsonString(phases_[i].first) << ": {"
+        << "\"wall\": " << p.wall << ", "
+        << "\"cpu\": " << p.cpu << ", "
+        << "\"calls\": " << p.calls << "}";
+  }
+  out << (phases_.empty() ? "" : "\n" + indent) << "},\n";
+
+  out << indent << "\"counters\": {";
+  for (size_t i = 0; i < counters_.size(); i++)
+    out << (i ? "," : "") << "\n"
+        << indent << "  " << jsonString(counters_[i].first) << ": " << counters_[i].second;
+  out << (counters_.empty() ? "" : "\n" + indent) << "}";
+}
+
+// - Timer -
+
+SkProfileTimer::SkProfileTimer(SkProfileRecord *record, const std::string &phase)
+  : record_(record), wall_(0), cpu_(0)
+{
+  if (record_) {
+    phase_ = phase;
+    wall_ = wallTime();
+    cpu_ = cpuTime();
+  }
+}
+
+void SkProfileTimer::stop()
+{
+  if (record_) {
+    record_->addPhase(phase_, wallTime() - wall_, cpuTime() - cpu_);
+    record_ = nullptr;
+  }
+}
+
+// - Profiler -
+
+SkProfileRecord *SkProfiler::addFile(const std::string &name)
+{
+  files_.push_back(File());
+  files_.back().record = SkProfileRecord(name);
+  return &files_.back().record;
+}
+
+void SkProfiler::addFunction(const SkProfileRecord &function)
+{
+  if (files_.empty())
+    addFile(std::string());
+  File &f = files_.back();
+  f.functions.push_back(function);
+  f.record.merge(function);
+}
+
+bool SkProfiler::writeJson(const std::string &path) const
+{
+  std::ofstream out(path.c_str());
+  if (!out.is_open())
+    return false;
+  writeJson(out);
+  return true;
+}
+
+void SkProfiler::writeJson(std::ostream &out) const
+{
+  // Totals over the project, files, and functions
+  SkProfileRecord total = project_;
+  foreach (const File &f, files_)
+    total.merge(f.record);
+
+  out << std::setprecision(6) << std::fixed
+      << "{\n"
+      << "  \"project\": {\n";
+  project_.writeJsonMembers(out, "    ");
+  out << "\n  },\n"
+      << "  \"total\": {\n";
+  total.writeJsonMembers(out, "    ");
+  out << "\n  },\n"
+      << "  \"files\": [";
+  bool firstFile = true;
+  foreach (const File &f, files_) {
+    out << (firstFile ? "" : ",") << "\n"
+        << "    {\n"
+        << "      \"name\": " << jsonString(f.record.name()) << ",\n";
+    f.record.writeJsonMembers(out, "      ");
+    out << ",\n"
+        << "      \"functions\": [";
+    bool firstFunction = true;
+    foreach (const SkProfileRecord &r, f.functions) {
+      out << (firstFunction ? "" : ",") << "\n"
+          << "        {\n"
+          << "          \"name\": " << jsonString(r.name()) << ",\n";
+      r.writeJsonMembers(out, "          ");
+      out << "\n        }";
+      firstFunction = false;
+    }
+    out << (f.functions.empty() ? "" : "\n      ") << "]\n"
+        << "    }";
+    firstFile = false;
+  }
+  out << (files_.empty() ? "" : "\n  ") << "]\n"
+      << "}\n";
+}
+
+// EOF
@@ -0,0 +1,108 @@
+#ifndef SKPROFILER_H
+#define SKPROFILER_H
+
+// skprofiler.h
+// 10/18/2026 jichi
+// Phase timings and counters of skgen.
+
+#include "sk/skdef.h"
+#include <iosfwd>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+///  Accumulated time of a phase in seconds
+struct SkProfilePhase
+{
+  double wall, cpu; // cpu is the time of the calling thread if supported
+  size_t calls;
+
+  SkProfilePhase() : wall(0), cpu(0), calls(0) {}
+};
+
+///  Phases and counters of a project, file, or function.
+class SkProfileRecord
+{
+  typedef SkProfileRecord Self;
+  typedef std::vector<std::pair<std::string, SkProfilePhase> > PhaseList;
+  typedef std::vector<std::pair<std::string, long long> > CounterList;
+
+  std::string name_;
+  PhaseList phases_;      // in the order of the first use
+  CounterList counters_;  // in the order of the first use
+
+public:
+  explicit SkProfileRecord(const std::string &name = std::string())
+    : name_(name) {}
+
+  const std::string &name() const { return name_; }
+
+  void addPhase(const std::string &phase, double wall, double cpu, size_t calls = 1);
+  void addCount(const std::string &counter, long long n = 1);
+
+  ///  Accumulate phases and counters of \p that.
+  void merge(const Self &that);
+
+  ///  Write "phases" and "counters" members of a JSON object.
+  void writeJsonMembers(std::ostream &out, const std::string &indent) const;
+};
+
+/**
+ *  \brief  Measure the wall and CPU time of a phase until destruction.
+ *
+ *  It does nothing if the record is null, so that it could be left in the
+ *  code when profiling is disabled.
+ */
+class SkProfileTimer
+{
+  SK_DISABLE_COPY(SkProfileTimer)
+
+  SkProfileRecord *record_;
+  std::string phase_;
+  double wall_, cpu_;
+
+public:
+  SkProfileTimer(SkProfileRecord *record, const std::string &phase);
+  ~SkProfileTimer() { stop(); }
+
+  ///  Add the time to the record. Later calls have no effect.
+  void stop();
+};
+
+/**
+ *  \brief  Profile of a skgen run.
+ *
+ *  File records accumulate the function records added to them. Records are
+ *  not synchronized, and each function record should be filled by one thread.
+ */
+class SkProfiler
+{
+  SK_DISABLE_COPY(SkProfiler)
+
+  struct File {
+    SkProfileRecord record;
+    std::list<SkProfileRecord> functions;
+  };
+
+  SkProfileRecord project_;
+  std::list<File> files_;
+
+public:
+  SkProfiler() {}
+
+  ///  Project-wide phases, such as the frontend
+  SkProfileRecord *project() { return &project_; }
+
+  ///  Start the profile of a source file. The record is valid until destruction.
+  SkProfileRecord *addFile(const std::string &name);
+
+  ///  Add the profile of a function to the last file.
+  void addFunction(const SkProfileRecord &function);
+
+  ///  Write the profile as JSON. Return false if failed to open the file.
+  bool writeJson(const std::string &path) const;
+  void writeJson(std::ostream &out) const;
+};
+
+#endif // SKPROFILER_H
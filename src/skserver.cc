@@ -0,0 +1,198 @@
+// skserver.cc
+// 10/18/2026 jichi
+
+#include "skserver.h"
+#include "xt/c++11.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define DEBUG "skserver"
+#include "xt/xdebug.h"
+
+#define REQUEST_TIMEOUT 10        // seconds to receive a request or send a response
+#define REQUEST_SIZE    (64 * 1024) // maximum bytes of a request line
+
+namespace { // anonymous
+
+  ///  Fill the socket address. Return false if the path is too long.
+  bool socketAddress(sockaddr_un &addr, const std::string &path)
+  {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+      std::cerr << "skserver:warning: socket path is too long: " << path << std::endl;
+      return false;
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+    return true;
+  }
+
+  bool writeAll(int fd, const std::string &data)
+  {
+    for (size_t pos = 0; pos < data.size();) {
+      ssize_t n = ::write(fd, data.data() + pos, data.size() - pos);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        return false;
+      }
+      pos += n;
+    }
+    return true;
+  }
+
+  ///  Read until the end of the stream.
+  std::string readAll(int fd)
+  {
+    std::string ret;
+    char buf[4096];
+    for (;;) {
+      ssize_t n = ::read(fd, buf, sizeof(buf));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        break;
+      ret.append(buf, n);
+    }
+    return ret;
+  }
+
+  /**
+   *  Read a line without the newline. Return false if the stream ends, the
+   *  socket times out, or \p limit bytes are read before the newline.
+   */
+  bool readLine(int fd, std::string &line, size_t limit)
+  {
+    line.clear();
+    char buf[4096];
+    while (line.size() < limit) {
+      ssize_t n = ::read(fd, buf, std::min(sizeof(buf), limit - line.size()));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return false;
+      line.append(buf, n);
+      size_t pos = line.find('\n');
+      if (pos != std::string::npos) {
+        line.erase(pos);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  ///  Limit blocking reads and writes on \p fd to \p seconds.
+  void setTimeout(int fd, int seconds)
+  {
+    timeval tv;
+    tv.tv_sec = seconds;
+    tv.tv_usec = 0;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  }
+
+  ///  Return if a server is accepting connections on \p addr.
+  bool isListening(const sockaddr_un &addr)
+  {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+      return false;
+    bool ret = !::connect(fd, (const sockaddr *)&addr, sizeof(addr));
+    ::close(fd);
+    return ret;
+  }
+
+} // anonymous namespace
+
+bool SkServer::serve(const std::string &path, const Handler &handler)
+{
+  sockaddr_un addr;
+  if (!socketAddress(addr, path))
+    return false;
+
+  ::signal(SIGPIPE, SIG_IGN); // clients could disconnect before the response
+
+  int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server < 0) {
+    std::perror("skserver");
+    return false;
+  }
+  if (isListening(addr)) {
+    std::cerr << "skserver:warning: another server is listening on " << path << std::endl;
+    ::close(server);
+    return false;
+  }
+  ::unlink(path.c_str()); // remove the socket left by a previous server that exited
+
+  // Other users could otherwise connect to quit or reload the server, or read the skeletons
+  mode_t mask = ::umask(077);
+  int error = ::bind(server, (sockaddr *)&addr, sizeof(addr));
+  ::umask(mask);
+  if (error || ::chmod(path.c_str(), 0600) || ::listen(server, 16)) {
+    std::perror(path.c_str());
+    ::close(server);
+    return false;
+  }
+  XD("listening on " << path);
+
+  bool running = true;
+  while (running) {
+    int client = ::accept(server, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR)
+        continue;
+      std::perror("skserver");
+      break;
+    }
+    // A client that never finishes its request only holds the server until the timeout
+    setTimeout(client, REQUEST_TIMEOUT);
+    std::string request,
+                response;
+    if (!readLine(client, request, REQUEST_SIZE)) {
+      XD("drop incomplete request: size = " << request.size());
+      writeAll(client, "error: incomplete request\n");
+    } else {
+      XD("request: " << request);
+      running = handler(request, response);
+      writeAll(client, response);
+    }
+    ::close(client);
+  }
+
+  ::close(server);
+  ::unlink(path.c_str());
+  XD("exit");
+  return true;
+}
+
+bool SkServer::request(std::string &response, const std::string &path, const std::string &request)
+{
+  sockaddr_un addr;
+  if (!socketAddress(addr, path))
+    return false;
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || ::connect(fd, (sockaddr *)&addr, sizeof(addr))) {
+    std::perror(path.c_str());
+    if (fd >= 0)
+      ::close(fd);
+    return false;
+  }
+  bool ok = writeAll(fd, request + "\n");
+  if (ok)
+    response = readAll(fd);
+  ::close(fd);
+  return ok;
+}
+
+// EOF
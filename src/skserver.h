@@ -0,0 +1,39 @@
+#ifndef SKSERVER_H
+#define SKSERVER_H
+
+// skserver.h
+// 10/18/2026 jichi
+// Local socket server to generate skeletons on request.
+
+#include <boost/function.hpp>
+#include <string>
+
+/**
+ *  \brief  Skeleton server over a UNIX domain socket.
+ *
+ *  Each connection carries one request line terminated by a newline, and the
+ *  response is the rest of the stream until the server closes the connection.
+ *  Requests are handled one by one in the calling thread. A request that is
+ *  not completed within a timeout or a size limit is dropped, so that one
+ *  client could not hold the server.
+ */
+namespace SkServer {
+
+  ///  Handle a request, and return false to stop the server.
+  typedef boost::function<bool (const std::string &request, std::string &response)> Handler;
+
+  /**
+   *  \brief  Listen on \p path until the handler returns false.
+   *
+   *  Return false if failed to listen, or another server is still listening
+   *  on \p path. A socket left by a server that exited is replaced. The
+   *  socket is only accessible by the user running the server.
+   */
+  bool serve(const std::string &path, const Handler &handler);
+
+  ///  Send the request to the server on \p path. Return false if failed to connect.
+  bool request(std::string &response, const std::string &path, const std::string &request);
+
+} // namespace SkServer
+
+#endif // SKSERVER_H